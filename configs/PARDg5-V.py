@@ -49,6 +49,15 @@ import Options
 
 from PARDg5GM import *
 
+# Way-partitioned L2, same configuration as Caches.L2Cache
+class PARDL2Cache(PARDCache):
+    assoc = 8
+    hit_latency = 20
+    response_latency = 20
+    mshrs = 20
+    tgts_per_mshr = 12
+    write_buffers = 8
+
 def build_pardg5v_system(np):
     if buildEnv['TARGET_ISA'] == "x86":
         pardsys = makePARDg5VSystem(test_mem_mode, options.num_cpus, bm[0])
@@ -98,8 +107,11 @@ def build_pardg5v_system(np):
     for i in xrange(np):
         pardsys.cpu[i].createThreads()
 
+    if options.pard_llc:
+        CacheConfig.L2Cache = PARDL2Cache
     CacheConfig.config_cache(options, pardsys)
     XMemConfig.config_mem(options, pardsys)
+    connectTagXBarCP(pardsys)
 
     return pardsys
 
@@ -108,11 +120,20 @@ def build_pardg5v_system(np):
 parser = optparse.OptionParser()
 Options.addCommonOptions(parser)
 Options.addFSOptions(parser)
+parser.add_option("--pard-llc", action="store_true",
+                  help="Use way-partitioned PARDCache as L2 cache")
+parser.add_option("--cp-server", type="string", default=None,
+                  help="Serve the control planes on this Unix socket "
+                       "(relative to the output directory)")
 (options, args) = parser.parse_args()
 if args:
     print "Error: script doesn't take any positional arguments"
     sys.exit(1)
 
+# the PARD LLC is the L2 cache, so it implies --l2cache
+if options.pard_llc:
+    options.l2cache = True
+
 # system under test can be any CPU
 (TestCPUClass, test_mem_mode, FutureClass) = XSimulation.setCPUClass(options)
 
@@ -136,9 +157,15 @@ prm.cpa.dma    = prm.iobus.slave
 prm.cpa.master = prm.cpn.slave
 root.prm = prm
 
-pardsys.cp.connectToNetwork(prm.cpn)
-pardsys.iobus.cp.connectToNetwork(prm.cpn)
-pardsys.cellx.ich.cp.connectToNetwork(prm.cpn)
+pardsys.cp.connectToNetwork(prm.cpn, prm.cpa)
+pardsys.iobus.cp.connectToNetwork(prm.cpn, prm.cpa)
+pardsys.cellx.ich.cp.connectToNetwork(prm.cpn, prm.cpa)
+pardsys.mem_ctrl.cp.connectToNetwork(prm.cpn, prm.cpa)
+pardsys.membus.cp.connectToNetwork(prm.cpn, prm.cpa)
+if options.pard_llc:
+    pardsys.l2.cp.connectToNetwork(prm.cpn, prm.cpa)
+if options.cp_server:
+    root.cpserver = CPServer(socket_path = options.cp_server)
 
 #### Change default UART port
 prm.pc.com_1.terminal.port = 4456;
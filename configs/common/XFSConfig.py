@@ -99,6 +99,13 @@ def connectX86ClassicSystem(x86_sys, numCPUs):
     x86_sys.system_port = x86_sys.membus.slave
 
 
+def connectTagXBarCP(x86_sys):
+    # account traffic of the CPU tag crossbars in the system crossbar
+    for cpu in x86_sys.cpu:
+        if hasattr(cpu, 'tagbus'):
+            cpu.tagbus.cp = x86_sys.membus.cp
+
+
 def makePARDg5VSystem(mem_mode, numCPUs = 1, mdesc = None):
     self = PARDg5VSystem()
 
@@ -207,18 +207,25 @@ def config_mem(options, system):
     ###for i in xrange(len(system.mem_ctrls)):
     ###    system.mem_ctrls[i].port = system.membus.memory_port
 
+    # PARDMemoryCtrl interleaves channels by itself, so each channel
+    # gets a contiguous, non-interleaved range
     from m5.objects import AddrRange
     from m5.util import convert
     mem_size = convert.toMemorySize(options.mem_size) + convert.toMemorySize('1GB')
-    mem_ctrls.append(create_mem_ctrl(cls, AddrRange(0, size = mem_size),
-                                     0, 1,
-                                     intlv_bits,
-                                     system.cache_line_size.value))
+    if mem_size % nbr_mem_ctrls:
+        fatal("Memory size must be a multiple of number of channels")
+    channel_size = mem_size / nbr_mem_ctrls
+    for i in xrange(nbr_mem_ctrls):
+        mem_ctrls.append(create_mem_ctrl(cls,
+                                         AddrRange(i * channel_size,
+                                                   size = channel_size),
+                                         0, 1, 0,
+                                         system.cache_line_size.value))
     #system.mem_ctrls = mem_ctrls
     #system.mem_ctrls[0].port = system.membus.memory_port
 
     from m5.objects import PARDMemoryCtrl
-    system.mem_ctrl = PARDMemoryCtrl(memories=mem_ctrls[0])
+    system.mem_ctrl = PARDMemoryCtrl(memories=mem_ctrls)
     system.mem_ctrl.port = system.membus.memory_port
     system.mem_ctrl.attachDRAM()
 
@@ -39,7 +39,8 @@
 PARDg5VSystemCP::PARDg5VSystemCP(const Params *p)
     : ControlPlane(p),
       param_table_entries(p->param_table_entries),
-      stat_table_entries(p->stat_table_entries)
+      stat_table_entries(p->stat_table_entries),
+      dsidIndex(p->param_table_entries)
 {
     // Construct SystemInfo struct
     sysinfo.cpuNr = 8;
@@ -67,14 +68,8 @@ PARDg5VSystemCP::getSegment(uint16_t DSid, int idx)
 {
     assert(idx < PARAMTABLE_SEGMENT_COUNT);
 
-    for (int i=0; i<param_table_entries; i++) {
-        if ((paramTable[i].flags & FLAG_VALID)
-              && (paramTable[i].DSid == DSid)) {
-            return &paramTable[i].segs[idx];
-        }
-    }
-
-    return NULL;
+    int row = dsidIndex.find(DSid);
+    return (row < 0) ? NULL : &paramTable[row].segs[idx];
 }
 
 const uint8_t *
@@ -89,14 +84,11 @@ int
 PARDg5VSystemCP::getCpuMask(uint16_t DSid, uint64_t *mask)
 {
     assert(mask);
-    for (int i=0; i<param_table_entries; i++) {
-        if ((paramTable[i].flags & FLAG_VALID)
-              && (paramTable[i].DSid == DSid)) {
-            *mask = paramTable[i].cpuMask;
-            return 0;
-        }
-    }
-    return -ENOENT;
+    int row = dsidIndex.find(DSid);
+    if (row < 0)
+        return -ENOENT;
+    *mask = paramTable[row].cpuMask;
+    return 0;
 }
 
 uint64_t *
@@ -173,6 +165,13 @@ PARDg5VSystemCP::updateTable(uint16_t DSid, uint32_t addr, uint64_t data)
     }
 
     *pdata = data;
+
+    if ((addr & ADDRTYPE_MASK) == ADDRTYPE_CFGTBL &&
+        cfgtbl_addr2type(addr) == CFGTBL_TYPE_PARAM) {
+        int row = cfgtbl_addr2row(addr);
+        dsidIndex.set(row, (paramTable[row].flags & FLAG_VALID) ?
+                           paramTable[row].DSid : -1);
+    }
 }
 
 PARDg5VSystemCP *
@@ -64,6 +64,7 @@
 
 #include "params/PARDg5VSystemCP.hh"
 #include "prm/ControlPlane.hh"
+#include "prm/DSidIndex.hh"
 
 #define CFGMEM_BITS	24
 #define CFGMEM_SIZE	(1<<CFGMEM_BITS)
@@ -110,6 +111,7 @@ class PARDg5VSystemCP : public ControlPlane
     struct StatEntry  *statTable;
     struct SystemInfo sysinfo;
     char *configMem;
+    DSidIndex dsidIndex;
 
   public:
     typedef PARDg5VSystemCPParams Params;
@@ -39,12 +39,15 @@ using namespace X86ISA;
 
 PARDg5VICHCP::PARDg5VICHCP(const Params *p)
     : ControlPlane(p),
-      param_table_entries(p->param_table_entries)
+      param_table_entries(p->param_table_entries),
+      dsidIndex(p->param_table_entries)
 {
     paramTable = new struct ParamEntry[param_table_entries];
     memset(paramTable, -1, sizeof(struct ParamEntry)*param_table_entries);
-    for (int i=0; i<param_table_entries; i++)
+    for (int i=0; i<param_table_entries; i++) {
         paramTable[i].flags = 0;
+        dsidIndex.set(i, paramTable[i].DSid);
+    }
 
     compoments_nr = 4;
     compoments = new struct ICH_COMPOMENT[4][ICH_COMPOMENTS_NR] {
@@ -91,6 +94,11 @@ PARDg5VICHCP::updateTable(uint16_t DSid, uint32_t addr, uint64_t data)
     }
 
     *pdata = data;
+
+    if ((addr & ADDRTYPE_MASK) == ADDRTYPE_CFGTBL) {
+        int row = cfgtbl_addr2row(addr);
+        dsidIndex.set(row, paramTable[row].DSid);
+    }
 }
 
 uint64_t *
@@ -131,12 +139,9 @@ PARDg5VICHCP::remapAddr(const uint16_t DSid, const Addr addr,
     struct ParamEntry *pParamEntry = NULL;
     struct ICH_COMPOMENT *pComp = NULL;
 
-    for (int i=0; i<param_table_entries; i++) {
-        if (paramTable[i].DSid == DSid) {
-            pParamEntry = &paramTable[i];
-            break;
-        }
-    }
+    int row = dsidIndex.find(DSid);
+    if (row >= 0)
+        pParamEntry = &paramTable[row];
 
     // No such DSid or ICH not selected for this DSid, return non-exist
     if (pParamEntry && pParamEntry->selected >= 4)
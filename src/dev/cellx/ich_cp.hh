@@ -44,6 +44,7 @@
 #include "base/addr_range.hh"
 #include "params/PARDg5VICHCP.hh"
 #include "prm/ControlPlane.hh"
+#include "prm/DSidIndex.hh"
 
 
 #define ICH_COMPOMENTS_NR       4
@@ -79,6 +80,8 @@ class PARDg5VICHCP : public ControlPlane
     int compoments_nr;
     struct ParamEntry *paramTable;
     struct ICH_COMPOMENT (*compoments)[ICH_COMPOMENTS_NR];
+    // every row matches its DSid, there is no valid flag
+    DSidIndex dsidIndex;
 
   public:
     typedef PARDg5VICHCPParams Params;
@@ -62,6 +62,12 @@ class PARDg5VIOHub(NoncoherentXBar):
     cp = Param.PARDg5VIOHubCP(PARDg5VIOHubCP(),
                               "Control plane for PARDg5-V IOHub")
 
+    # Direct-mapped cache of address decoding, 0 to disable
+    decode_cache_entries = Param.Unsigned(64,
+                      "Number of entries of address decode cache")
+    decode_page_size = Param.MemorySize('4kB',
+                      "Address decode cache granularity")
+
     def attachRemappedMaster(self, remapped_master):
         remapped_master.remapper = PARDg5VIOHubRemapper()
         remapped_master.remapper.slave = remapped_master.master
@@ -45,7 +45,8 @@ PARDg5VIOHub::PARDg5VIOHub(PARDg5VIOHubParams *p)
                        p->port_master_connection_count=0,
                        p->port_default_connection_count=0,
                        p)),
-      cp(p->cp)
+      cp(p->cp),
+      decodeCache(p->decode_cache_entries, p->decode_page_size)
 {
     // Hack 3/3: restore master/default port cont
     p->port_master_connection_count = mcnt;
@@ -169,6 +170,38 @@ PARDg5VIOHub::startup()
     cp->recvDeviceChange(devices);
 }
 
+void
+PARDg5VIOHub::regStats()
+{
+    NoncoherentXBar::regStats();
+    decodeCache.regStats(name());
+}
+
+void
+PARDg5VIOHub::recvRangeChange(PortID master_port_id)
+{
+    // PCI BARs may be moved at runtime
+    decodeCache.invalidate();
+    NoncoherentXBar::recvRangeChange(master_port_id);
+}
+
+PortID
+PARDg5VIOHub::routeAddr(Addr addr)
+{
+    PortID port_id = decodeCache.lookup(addr);
+    if (port_id != InvalidPortID)
+        return port_id;
+
+    auto i = portMap.find(addr);
+    if (i != portMap.end()) {
+        decodeCache.insert(addr, i->first, i->second);
+        return i->second;
+    }
+
+    // default port, or fatal
+    return findPort(addr);
+}
+
 #define calcPciConfigAddr(bus, dev, func) \
     (PhysAddrPrefixPciConfig | (func << 8) | (dev << 11))
 Addr
@@ -213,7 +246,7 @@ void
 PARDg5VIOHub::hookPciAccess(PacketPtr pkt)
 {
     // if access to PCI configure space
-    MasterPort *port = masterPorts[findPort(pkt->getAddr())];
+    MasterPort *port = masterPorts[routeAddr(pkt->getAddr())];
     if (__isPciConfigPort(port->getSlavePort().name())) {
         int offset = pkt->getAddr() & PCI_CONFIG_SIZE;
 
@@ -35,6 +35,7 @@
 
 #include "dev/pard/iohub_cp.hh"
 #include "mem/noncoherent_xbar.hh"
+#include "mem/pard_decode_cache.hh"
 #include "mem/tag_addr_mapper.hh"
 #include "params/PARDg5VIOHub.hh"
 #include "params/PARDg5VIOHubRemapper.hh"
@@ -96,6 +97,9 @@ class PARDg5VIOHub : public NoncoherentXBar
 
     PARDg5VIOHubCP *cp;
 
+    /** Recently decoded pages of hookPciAccess */
+    DecodeCache decodeCache;
+
   protected:
     // All PCI devices
     std::vector<struct PCI_DEVICE *> devices;
@@ -110,6 +114,9 @@ class PARDg5VIOHub : public NoncoherentXBar
     Addr remapAddr(Addr addr, uint16_t DSid);
     void hookPciAccess(PacketPtr pkt);
 
+    PortID routeAddr(Addr addr);
+    void recvRangeChange(PortID master_port_id);
+
     struct PCI_DEVICE * getPciDevice(MemObject *owner)
     {
         for (auto dev : devices)
@@ -139,6 +146,7 @@ class PARDg5VIOHub : public NoncoherentXBar
     virtual ~PARDg5VIOHub();
 
     virtual void startup();
+    virtual void regStats();
 
 };
 
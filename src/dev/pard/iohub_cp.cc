@@ -42,7 +42,8 @@ using namespace X86ISA;
 PARDg5VIOHubCP::PARDg5VIOHubCP(const Params *p)
     : ControlPlane(p),
       param_table_entries(p->param_table_entries),
-      stat_table_entries(p->stat_table_entries)
+      stat_table_entries(p->stat_table_entries),
+      dsidIndex(p->param_table_entries)
 {
     // Construct IOHubInfo struct
     memset(&ioInfo, 0, sizeof(ioInfo));
@@ -105,6 +106,9 @@ PARDg5VIOHubCP::updateTable(uint16_t DSid, uint32_t addr, uint64_t data)
         (char *)pdata <  (char *)paramTable+param_table_entries*sizeof(struct ParamEntry))
     {
         int idx = ((uint64_t)pdata - (uint64_t)paramTable)/sizeof(struct ParamEntry);
+        dsidIndex.set(idx, (paramTable[idx].flags & FLAG_VALID) ?
+                           paramTable[idx].DSid : -1);
+
         if ((char *)pdata <= (char *)&paramTable[idx].device_mask &&
             (char *)pdata+sizeof(*pdata)
               >= (char *)&paramTable[idx].device_mask+sizeof(paramTable[idx].device_mask))
@@ -202,17 +206,8 @@ PARDg5VIOHubCP::recvDeviceChange(
 uint32_t
 PARDg5VIOHubCP::getDeviceMask(uint16_t DSid)
 {
-    uint32_t device_mask = 0;
-
-    for (int i=0; i<param_table_entries; i++) {
-        if ((paramTable[i].flags & FLAG_VALID) &&
-            (paramTable[i].DSid == DSid)) {
-            device_mask = paramTable[i].device_mask;
-            break;
-        }
-    }
-
-    return device_mask;
+    int row = dsidIndex.find(DSid);
+    return (row < 0) ? 0 : paramTable[row].device_mask;
 }
 
 
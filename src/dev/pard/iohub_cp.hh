@@ -45,6 +45,7 @@
 #include "base/addr_range.hh"
 #include "params/PARDg5VIOHubCP.hh"
 #include "prm/ControlPlane.hh"
+#include "prm/DSidIndex.hh"
 
 /**
  * Config Table
@@ -98,6 +99,7 @@ class PARDg5VIOHubCP : public ControlPlane
     struct StatEntry  *statTable;
     struct ParamEntry *paramTable;
     struct IOHubInfo ioInfo;
+    DSidIndex dsidIndex;
 
     PARDg5VIOHub *iohub;
 
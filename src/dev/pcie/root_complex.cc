@@ -81,7 +81,7 @@ RootComplex::RCMasterPort::schedTimingReq(PacketPtr pkt, Tick when)
     if (!pkt->memInhibitAsserted() && pkt->needsResponse()) {
         // Update the sender state so we can deal with the response
         // appropriately
-        pkt->pushSenderState(new RequestState(pkt->getSrc()));
+        pkt->pushSenderState(new RequestState(&rc, pkt->getSrc()));
     }
 
     // If we're about to put this packet at the head of the queue, we
@@ -92,11 +92,11 @@ RootComplex::RCMasterPort::schedTimingReq(PacketPtr pkt, Tick when)
         rc.schedule(sendEvent, when);
     }
 
-    assert(transmitList.size() != reqQueueLimit);
-
     // Build PCI-Express TLP packet and add it to transmitList
     PciExpressTLP *tlp = rc.buildTLP(pkt);
-    transmitList.push_back(DeferredPacket(tlp, when));
+    uint16_t DSid = DSidQoS::classOf(pkt);
+    qos.take(DSid);
+    transmitList.push(DSid, DeferredPacket(tlp, when));
 }
 
 bool
@@ -124,18 +124,13 @@ RootComplex::RCMasterPort::recvTimingResp(PacketPtr pkt)
 bool
 RootComplex::RCMasterPort::checkFunctional(PacketPtr pkt)
 {
-    bool found = false;
-    auto i = transmitList.begin();
-
-    while(i != transmitList.end() && !found) {
-         PciExpressTLP *tlp = dynamic_cast<PciExpressTLP *>((*i).pkt);
+    bool found = transmitList.find([pkt](const DeferredPacket &d) {
+         PciExpressTLP *tlp = dynamic_cast<PciExpressTLP *>(d.pkt);
          assert(tlp);
-         if (pkt->checkFunctional(tlp->pkt)) {
-              pkt->makeResponse();
-              found = true;
-         }
-         ++i;
-    }
+         return pkt->checkFunctional(tlp->pkt);
+    });
+    if (found)
+        pkt->makeResponse();
 
     return found;
 }
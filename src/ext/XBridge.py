@@ -53,3 +53,13 @@ class XBridge(MemObject):
     delay = Param.Latency('0ns', "The latency of this bridge")
     ranges = VectorParam.AddrRange([AllMemory],
                                    "Address ranges to pass through the bridge")
+
+    # Per-DSid QoS of the request and response queues: qos_dsids[i] has
+    # qos_reserved[i] slots of each queue to itself and is served before
+    # DSids of lower qos_priority[i]. Other DSids share the remaining
+    # slots with priority 0.
+    qos_dsids = VectorParam.Unsigned([], "DSids with QoS settings")
+    qos_reserved = VectorParam.Unsigned([],
+                      "Queue slots reserved for each of qos_dsids")
+    qos_priority = VectorParam.Unsigned([],
+                      "Service priority of each of qos_dsids")
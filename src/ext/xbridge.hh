@@ -55,6 +55,8 @@
 
 #include "base/types.hh"
 #include "mem/mem_object.hh"
+#include "mem/pard_qos_queue.hh"
+#include "mem/pard_sender_state.hh"
 #include "params/XBridge.hh"
 
 /**
@@ -79,14 +81,15 @@ class XBridge : public MemObject
      * state and original source. It has enough information to also
      * restore the response once it comes back to the bridge.
      */
-    class RequestState : public Packet::SenderState
+    class RequestState : public PooledSenderState<RequestState>
     {
 
       public:
 
         const PortID origSrc;
 
-        RequestState(PortID orig_src) : origSrc(orig_src)
+        RequestState(const XBridge *owner, PortID orig_src)
+            : PooledSenderState<RequestState>(owner), origSrc(orig_src)
         { }
 
     };
@@ -135,29 +138,35 @@ class XBridge : public MemObject
         /** Address ranges to pass through the bridge */
         const AddrRangeList ranges;
 
+        /**
+         * Space reserved for outstanding responses, per DSid. Taken
+         * when a request expecting a response is accepted and given
+         * back once the response is sent.
+         */
+        DSidQoS qos;
+
         /**
          * Response packet queue. Response packets are held in this
          * queue for a specified delay to model the processing delay
-         * of the bridge. We use a deque as we need to iterate over
-         * the items for functional accesses.
+         * of the bridge. Each DSid has its own sub-queue, served in
+         * order of priority.
          */
-        std::deque<DeferredPacket> transmitList;
-
-        /** Counter to track the outstanding responses. */
-        unsigned int outstandingResponses;
+        DSidQoSQueue<DeferredPacket> transmitList;
 
         /** If we should send a retry when space becomes available. */
         bool retryReq;
 
-        /** Max queue size for reserved responses. */
-        unsigned int respQueueLimit;
+        /** QoS class of the stalled request, and if it needs a response */
+        uint16_t retryDSid;
+        bool retryExpectsResp;
 
         /**
          * Is this side blocked from accepting new response packets.
          *
-         * @return true if the reserved space has reached the set limit
+         * @return true if DSid has used up its reserved and the shared
+         *         space
          */
-        bool respQueueFull() const;
+        bool respQueueFull(uint16_t DSid) const;
 
         /**
          * Handle send event, scheduled when the packet at the head of
@@ -198,7 +207,9 @@ class XBridge : public MemObject
         /**
          * Retry any stalled request that we have failed to accept at
          * an earlier point in time. This call will do nothing if no
-         * request is waiting.
+         * request is waiting, or if its DSid still has no space in
+         * the request queue, or in the response queue if it expects a
+         * response.
          */
         void retryStalledReq();
 
@@ -247,16 +258,16 @@ class XBridge : public MemObject
         /** Minimum delay though this bridge. */
         const Cycles delay;
 
+        /** Space of the request queue, per DSid */
+        DSidQoS qos;
+
         /**
          * Request packet queue. Request packets are held in this
          * queue for a specified delay to model the processing delay
-         * of the bridge.  We use a deque as we need to iterate over
-         * the items for functional accesses.
+         * of the bridge. Each DSid has its own sub-queue, served in
+         * order of priority.
          */
-        std::deque<DeferredPacket> transmitList;
-
-        /** Max queue size for request packets */
-        const unsigned int reqQueueLimit;
+        DSidQoSQueue<DeferredPacket> transmitList;
 
         /**
          * Handle send event, scheduled when the packet at the head of
@@ -291,6 +302,15 @@ class XBridge : public MemObject
          */
         bool reqQueueFull() const;
 
+        /**
+         * Is this side blocked from accepting new request packets of
+         * DSid.
+         *
+         * @return true if DSid has used up its reserved and the shared
+         *         space
+         */
+        bool reqQueueFull(uint16_t DSid) const;
+
         /**
          * Queue a request packet to be sent out later and also schedule
          * a send if necessary.
@@ -324,6 +344,8 @@ class XBridge : public MemObject
   public:
 
     typedef XBridgeParams Params;
+    const Params *params() const
+    { return dynamic_cast<const Params *>(_params); }
 
     XBridge(Params *p) : MemObject(p) { }
 };
@@ -27,6 +27,7 @@
 # Authors: Jiuyue Ma
 
 from XBar import CoherentXBar
+from PARDSystemXBar import PARDSystemXBarCP
 from m5.params import *
 from m5.proxy import *
 
@@ -37,3 +38,14 @@ class CoherentTagXBar(CoherentXBar):
     DSid = Param.Unsigned(0, "The DSid to be tagged")
     DSid_base_addr = Param.Addr(0xFFFFFFF0, "Address to access DSid")
 
+    # Requests within DSid_ranges[i] are tagged with DSid_range_map[i],
+    # others with DSid
+    DSid_ranges = VectorParam.AddrRange([], "Address ranges to classify")
+    DSid_range_map = VectorParam.Unsigned([], "DSid of each DSid_ranges")
+
+    # Traffic of the tagged requests is accounted to a link of its own
+    # (XBAR_LINK_TAG + i) in this control plane, e.g. the one of system
+    # crossbar
+    cp = Param.PARDSystemXBarCP(NULL,
+                                "Control plane to account traffic to")
+
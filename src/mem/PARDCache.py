@@ -0,0 +1,76 @@
+# Copyright (c) 2014 Institute of Computing Technology, CAS
+# All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions are
+# met: redistributions of source code must retain the above copyright
+# notice, this list of conditions and the following disclaimer;
+# redistributions in binary form must reproduce the above copyright
+# notice, this list of conditions and the following disclaimer in the
+# documentation and/or other materials provided with the distribution;
+# neither the name of the copyright holders nor the names of its
+# contributors may be used to endorse or promote products derived from
+# this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+# "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+# LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+# A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+# OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+# SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+# LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+# DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+# THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#
+# Authors: Jiuyue Ma
+
+
+from BaseCache import BaseCache
+from ControlPlane import ControlPlane
+from Prefetcher import StridePrefetcher
+from Tags import LRU
+from m5.params import *
+from m5.proxy import *
+
+class PARDCacheCP(ControlPlane):
+    type = 'PARDCacheCP'
+    cxx_header = "mem/pard_cache_cp.hh"
+
+    # CPN address 5:0
+    cp_dev = 5
+    cp_fun = 0
+    # Type 'C' Cache, IDENT: PARDg5VLLCCP
+    Type = 0x43
+    IDENT = "PARDg5VLLCCP"
+
+    param_table_entries = Param.Int(32, "Number of parameter table entries")
+    stat_table_entries  = Param.Int(32, "Number of statistics table entries")
+    trigger_table_entries = 16
+
+class PARDLRU(LRU):
+    type = 'PARDLRU'
+    cxx_header = "mem/pard_cache_tags.hh"
+
+    # Per-DSid statistics are kept on one out of this many sets,
+    # 1 accounts the whole cache
+    monitor_sample_interval = Param.Unsigned(1,
+                      "Account per-DSid statistics on every n-th set")
+
+# Stride prefetcher under the per-DSid prefetch controls of the cache CP
+class PARDStridePrefetcher(StridePrefetcher):
+    type = 'PARDStridePrefetcher'
+    cxx_header = "mem/pard_prefetcher.hh"
+
+class PARDCache(BaseCache):
+    type = 'PARDCache'
+    cxx_header = "mem/pard_cache.hh"
+
+    tags = PARDLRU()
+    cp = Param.PARDCacheCP(PARDCacheCP(), "Control plane")
+
+    # Utility-based way repartitioning, 0 disables the utility monitor
+    repartition_epoch = Param.Latency('0ns', "Way repartition interval")
+    umon_sample_interval = Param.Unsigned(32,
+                      "Utility monitor samples one out of this many sets")
@@ -1,7 +1,41 @@
 from m5.params import *
+from m5.proxy import *
 from MemObject import MemObject
 from XBar import CoherentXBar, NoncoherentXBar
 from Bridge import Bridge
+from ControlPlane import ControlPlane
+
+# Front-end scheduling policy of PARDMemoryCtrl
+#  - pard_fcfs: pass requests to DRAM controller in arrival order
+#  - pard_frfcfs: prefer requests hitting an open row, then oldest
+#  - pard_prio_frfcfs: prefer higher DSid priority, then FR-FCFS
+class PARDMemSched(Enum): vals = ['pard_fcfs', 'pard_frfcfs',
+                                  'pard_prio_frfcfs']
+
+# Host backing of LDom memory
+#  - pard_backing_shared: all LDoms share the flat physical memory
+#  - pard_backing_anon: own anonymous mapping per LDom
+#  - pard_backing_hugepage: own anonymous huge page mapping per LDom
+#  - pard_backing_file: own file in backing_dir per LDom
+class PARDMemBacking(Enum): vals = ['pard_backing_shared',
+                                    'pard_backing_anon',
+                                    'pard_backing_hugepage',
+                                    'pard_backing_file']
+
+class PARDMemoryCtrlCP(ControlPlane):
+    type = 'PARDMemoryCtrlCP'
+    cxx_header = "mem/pard_mem_ctrl_cp.hh"
+
+    # CPN address 3:0
+    cp_dev = 3
+    cp_fun = 0
+    # Type 'M' Memory Controller, IDENT: PARDg5VMemCP
+    Type = 0x4D
+    IDENT = "PARDg5VMemCP"
+
+    param_table_entries = Param.Int(32, "Number of parameter table entries")
+    stat_table_entries  = Param.Int(32, "Number of statistics table entries")
+    trigger_table_entries = 16
 
 class PARDMemoryCtrl(MemObject):
     type = 'PARDMemoryCtrl'
@@ -9,9 +43,12 @@ class PARDMemoryCtrl(MemObject):
 
     port = SlavePort("Slave port")
 
-    # Internal DRAM Controller
-    #  - TODO: Maybe we should use multiple DRAMCtrl?
-    memories = Param.AbstractMemory("Internal memories")
+    # Internal DRAM Controllers, one per channel. Channels are of the
+    # same size and laid out contiguously, PARDMemoryCtrl does the
+    # channel interleaving by itself.
+    memories = VectorParam.AbstractMemory("Internal memories")
+    channel_intlv_size = Param.MemorySize('256B',
+                      "Channel interleaving granularity")
 
     # Internal bus that connect all DRAMCtrl together
     _internal_bus = NoncoherentXBar()
@@ -23,10 +60,48 @@ class PARDMemoryCtrl(MemObject):
     # Master port to access DRAMCtrl
     internal_port = MasterPort("Master port connect to internal bus")
 
+    # PARD Memory Controller Control Plane
+    cp = Param.PARDMemoryCtrlCP(PARDMemoryCtrlCP(),
+                                "Control plane for PARD memory controller")
+
+    # DSid remapping table, indexed by DSid
+    remap_table_entries = Param.Unsigned(256,
+                      "Number of entries in DSid remapping table")
+
+    # Default layout: DSid#i ==> [i*default_ldom_size, (i+1)*default_ldom_size)
+    default_ldoms = Param.Unsigned(4, "Number of LDoms remapped at startup")
+    default_ldom_size = Param.MemorySize('2GB',
+                      "Memory size of each LDom remapped at startup")
+
+    # Front-end scheduler, policy and starvation limit can be changed
+    # at runtime through control plane
+    sched_policy = Param.PARDMemSched('pard_fcfs', "Scheduling policy")
+    read_queue_size = Param.Unsigned(32, "Number of queued reads")
+    write_queue_size = Param.Unsigned(64, "Number of queued writes")
+    write_high_thresh_perc = Param.Percent(85, "Threshold to start "
+                                           "draining queued writes")
+    write_low_thresh_perc = Param.Percent(50, "Threshold to stop "
+                                          "draining queued writes")
+    starvation_limit = Param.Latency('1us', "Age after which a request "
+                                     "is scheduled before any other")
+    max_outstanding = Param.Unsigned(16, "Max requests outstanding in "
+                                     "DRAM controller")
+
+    # Per-DSid bandwidth regulator, rate and burst are set through
+    # control plane
+    throttle_queue_size = Param.Unsigned(16, "Number of requests held "
+                                         "per throttled DSid")
+
+    # Per-LDom host backing, memory of an LDom can be dropped or
+    # synced to its file through control plane
+    system = Param.System(Parent.any, "System we belong to")
+    ldom_backing = Param.PARDMemBacking('pard_backing_shared',
+                                        "Host backing of LDom memory")
+    backing_dir = Param.String("", "Directory of LDom backing files")
+
     def attachDRAM(self):
         self.internal_port = self.internal_bridge.slave
         self.internal_bridge.master = self.internal_bus.slave
-        #for mem in self.memories:
-        #    self.internal_bus.master = mem.port
-        self.internal_bus.master = self.memories.port
+        for mem in self.memories:
+            self.internal_bus.master = mem.port
 
@@ -27,9 +27,29 @@
 # Authors: Jiuyue Ma
 
 from XBar import CoherentXBar
+from ControlPlane import ControlPlane
 from m5.params import *
 from m5.proxy import *
 
+# Arbitration of the memory_port request layer
+#  - pard_arb_fifo: ports are retried in arrival order
+#  - pard_arb_drr: deficit round-robin among DSids, by weight
+class PARDXBarArb(Enum): vals = ['pard_arb_fifo', 'pard_arb_drr']
+
+class PARDSystemXBarCP(ControlPlane):
+    type = 'PARDSystemXBarCP'
+    cxx_header = "mem/pard_system_xbar_cp.hh"
+
+    # CPN address 4:0
+    cp_dev = 4
+    cp_fun = 0
+    # Type 'X' Crossbar, IDENT: PARDg5VBusCP
+    Type = 0x58
+    IDENT = "PARDg5VBusCP"
+
+    param_table_entries = Param.Int(32, "Number of parameter table entries")
+    stat_table_entries  = Param.Int(32, "Number of statistics table entries")
+
 class PARDSystemXBar(CoherentXBar):
     type = 'PARDSystemXBar'
     cxx_header = "mem/pard_system_xbar.hh"
@@ -45,3 +65,24 @@ class PARDSystemXBar(CoherentXBar):
     io_ranges = VectorParam.AddrRange([],
                       "Ranges of address that should pass to I/O port")
 
+    # Arbitration of memory_port, policy and weights can be changed
+    # at runtime through control plane
+    arbitration = Param.PARDXBarArb('pard_arb_fifo',
+                      "Arbitration of memory_port request layer")
+    default_weight = Param.Unsigned(1, "Weight of DSids not configured")
+
+    # Snoop only caches of the requesting LDom, DSids owned by each
+    # cache are learned from the requests it issues
+    dsid_snoop_filter = Param.Bool(False,
+                      "Partition snoops by DSid")
+    snoop_shared_ranges = VectorParam.AddrRange([],
+                      "Ranges shared among LDoms, always broadcast snoops")
+
+    # Direct-mapped cache of address decoding, 0 to disable
+    decode_cache_entries = Param.Unsigned(64,
+                      "Number of entries of address decode cache")
+    decode_page_size = Param.MemorySize('4kB',
+                      "Address decode cache granularity")
+
+    cp = Param.PARDSystemXBarCP(PARDSystemXBarCP(),
+                                "Control plane for PARD system crossbar")
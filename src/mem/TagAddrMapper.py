@@ -55,3 +55,15 @@ class TagAddrMapper(MemObject):
     master = MasterPort("Master port")
     slave = SlavePort("Slave port")
 
+# Page-granular mapper, each DSid owns a page table from guest physical
+# pages to machine pages, programmed through commands of cp
+class PagedTagAddrMapper(TagAddrMapper):
+    type = 'PagedTagAddrMapper'
+    cxx_header = 'mem/paged_tag_addr_mapper.hh'
+
+    ranges = VectorParam.AddrRange([AddrRange(0, Addr.max)],
+                                   "Address ranges to pass through")
+    page_size = Param.MemorySize('4kB', "Remapping granularity")
+    max_dsids = Param.Unsigned(256, "Number of DSids with a page table")
+    tc_entries = Param.Unsigned(16, "Translation cache entries per DSid")
+    cp = Param.ControlPlane(NULL, "Control plane programming page tables")
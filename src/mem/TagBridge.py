@@ -41,6 +41,21 @@ class TagBridge(MemObject):
     ranges = VectorParam.AddrRange([AllMemory],
                                    "Address ranges to pass through the bridge")
 
+    # Per-DSid QoS of the request and response queues: qos_dsids[i] has
+    # qos_reserved[i] slots of each queue to itself and is served before
+    # DSids of lower qos_priority[i]. Other DSids share the remaining
+    # slots with priority 0.
+    qos_dsids = VectorParam.Unsigned([], "DSids with QoS settings")
+    qos_reserved = VectorParam.Unsigned([],
+                      "Queue slots reserved for each of qos_dsids")
+    qos_priority = VectorParam.Unsigned([],
+                      "Service priority of each of qos_dsids")
+
     DSid = Param.Unsigned(0, "The DSid to be tagged")
     DSid_base_addr = Param.Addr(0xFFFFFFF0, "Address to access DSid")
 
+    # Requests within DSid_ranges[i] are tagged with DSid_range_map[i],
+    # others with DSid
+    DSid_ranges = VectorParam.AddrRange([], "Address ranges to classify")
+    DSid_range_map = VectorParam.Unsigned([], "DSid of each DSid_ranges")
+
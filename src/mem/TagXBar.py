@@ -29,6 +29,7 @@
 from m5.params import *
 from m5.proxy import *
 from XBar import CoherentXBar
+from PARDSystemXBar import PARDSystemXBarCP
 
 class TagXBar(CoherentXBar):
     type = 'TagXBar'
@@ -37,3 +38,9 @@ class TagXBar(CoherentXBar):
     DSid = Param.Unsigned(0, "The DSid to be tagged")
     DSid_base_addr = Param.Addr(0xFFFFFFF0, "Address to access DSid")
 
+    # Traffic of the tagged requests is accounted to a link of its own
+    # (XBAR_LINK_TAG + i) in this control plane, e.g. the one of system
+    # crossbar
+    cp = Param.PARDSystemXBarCP(NULL,
+                                "Control plane to account traffic to")
+
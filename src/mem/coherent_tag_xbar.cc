@@ -43,7 +43,10 @@
 CoherentTagXBar::CoherentTagXBar(const CoherentTagXBarParams *p,
                          const unsigned int port_slave_connection_count)
     : CoherentXBar(p),
-      DSid(p->DSid), DSid_base_addr(p->DSid_base_addr)
+      DSid(p->DSid), DSid_base_addr(p->DSid_base_addr),
+      classifier(name(), p->DSid, p->DSid_ranges, p->DSid_range_map),
+      cp(p->cp), link(cp ? cp->regTagLink(name()) : -1),
+      reqWaitSince(port_slave_connection_count, MaxTick)
 {
     // create the slave ports, because they are faked in CoherentXBar
     // see CoherentTagXBarParams::create()
@@ -61,6 +64,41 @@ CoherentTagXBar::~CoherentTagXBar()
 {
 }
 
+bool
+CoherentTagXBar::recvTaggedTimingReq(PacketPtr pkt, PortID slave_port_id)
+{
+    if (!cp || pkt->isExpressSnoop())
+        return recvTimingReq(pkt, slave_port_id);
+
+    // the packet may be gone once it is sent
+    uint16_t pkt_dsid = pkt->getDSid();
+    unsigned int pkt_size = pkt->hasData() ? pkt->getSize() : 0;
+
+    if (!recvTimingReq(pkt, slave_port_id)) {
+        if (reqWaitSince[slave_port_id] == MaxTick)
+            reqWaitSince[slave_port_id] = curTick();
+        cp->recordRetry(pkt_dsid, link);
+        return false;
+    }
+
+    Tick queued = 0;
+    if (reqWaitSince[slave_port_id] != MaxTick) {
+        queued = curTick() - reqWaitSince[slave_port_id];
+        reqWaitSince[slave_port_id] = MaxTick;
+    }
+    cp->recordTraffic(pkt_dsid, link, pkt_size, queued);
+    return true;
+}
+
+Tick
+CoherentTagXBar::recvTaggedAtomic(PacketPtr pkt, PortID slave_port_id)
+{
+    if (cp)
+        cp->recordTraffic(pkt->getDSid(), link,
+                          pkt->hasData() ? pkt->getSize() : 0, 0);
+    return recvAtomic(pkt, slave_port_id);
+}
+
 CoherentTagXBar *
 CoherentTagXBarParams::create()
 {
@@ -37,6 +37,8 @@
 #define __MEM_COHERENT_TAG_XBAR_HH__
 
 #include "mem/coherent_xbar.hh"
+#include "mem/pard_dsid_classifier.hh"
+#include "mem/pard_system_xbar_cp.hh"
 #include "params/CoherentTagXBar.hh"
 
 /**
@@ -75,8 +77,8 @@ class CoherentTagXBar : public CoherentXBar
          */
         virtual bool recvTimingReq(PacketPtr pkt) {
             assert(!pkt->hasDSid());
-            pkt->setDSid(xbar.DSid);
-            return xbar.recvTimingReq(pkt, id);
+            pkt->setDSid(xbar.classifier.classify(pkt->getAddr()));
+            return xbar.recvTaggedTimingReq(pkt, id);
         }
 
         /**
@@ -84,8 +86,8 @@ class CoherentTagXBar : public CoherentXBar
          */
         virtual Tick recvAtomic(PacketPtr pkt) {
             //assert(!pkt->hasDSid());
-            pkt->setDSid(xbar.DSid);
-            return xbar.recvAtomic(pkt, id);
+            pkt->setDSid(xbar.classifier.classify(pkt->getAddr()));
+            return xbar.recvTaggedAtomic(pkt, id);
         }
 
         /**
@@ -93,7 +95,7 @@ class CoherentTagXBar : public CoherentXBar
          */
         virtual void recvFunctional(PacketPtr pkt) {
             assert(!pkt->hasDSid());
-            pkt->setDSid(xbar.DSid);
+            pkt->setDSid(xbar.classifier.classify(pkt->getAddr()));
             xbar.recvFunctional(pkt, id);
         }
 
@@ -103,8 +105,22 @@ class CoherentTagXBar : public CoherentXBar
     uint16_t DSid;
 
     /** DSid base address */
-    Addr DSid_base_addr;        // TODO: check req addr, if in range, return DSid
+    Addr DSid_base_addr;
 
+    /** DSid of each address range, DSid for the others */
+    DSidClassifier classifier;
+
+    /** Control plane to account traffic to, may be NULL */
+    PARDSystemXBarCP *cp;
+    /** Link of this crossbar in cp */
+    int link;
+
+    /** Tick each slave port was first refused, MaxTick if not waiting */
+    std::vector<Tick> reqWaitSince;
+
+    /** Forward a tagged request, and account it to the control plane */
+    bool recvTaggedTimingReq(PacketPtr pkt, PortID slave_port_id);
+    Tick recvTaggedAtomic(PacketPtr pkt, PortID slave_port_id);
 
   public:
 
@@ -0,0 +1,206 @@
+/*
+ * Copyright (c) 2014 Institute of Computing Technology, CAS
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met: redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer;
+ * redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution;
+ * neither the name of the copyright holders nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Authors: Jiuyue Ma
+ */
+
+/**
+ * @file
+ * Definition of a page-granular DSid address mapper.
+ */
+
+#include "base/intmath.hh"
+#include "debug/TagAddrMapper.hh"
+#include "mem/paged_tag_addr_mapper.hh"
+#include "prm/ControlPlane.hh"
+
+PagedTagAddrMapper::PagedTagAddrMapper(const PagedTagAddrMapperParams *p)
+    : TagAddrMapper(p),
+      ranges(p->ranges.begin(), p->ranges.end()),
+      pageShift(floorLog2(p->page_size)),
+      maxDSids(p->max_dsids),
+      tcEntries(p->tc_entries),
+      pageTables(p->max_dsids),
+      tc(p->max_dsids * p->tc_entries)
+{
+    fatal_if(!isPowerOf2(p->page_size), "%s: page size %d is not a power "
+             "of 2\n", name(), p->page_size);
+    fatal_if(!isPowerOf2(tcEntries), "%s: translation cache entries %d is "
+             "not a power of 2\n", name(), tcEntries);
+
+    for (auto &entry : tc) {
+        entry.gpn = entry.mpn = 0;
+        entry.valid = false;
+    }
+
+    if (p->cp)
+        p->cp->registerCommandHandler(static_cast<ICommandHandler *>(this));
+}
+
+void
+PagedTagAddrMapper::regStats()
+{
+    TagAddrMapper::regStats();
+
+    using namespace Stats;
+
+    tcHits
+        .name(name() + ".tc_hits")
+        .desc("Number of translation cache hits")
+        ;
+    tcMisses
+        .name(name() + ".tc_misses")
+        .desc("Number of translation cache misses")
+        ;
+    unmappedAccesses
+        .name(name() + ".unmapped_accesses")
+        .desc("Number of accesses to unmapped pages")
+        ;
+    tcHitRate
+        .name(name() + ".tc_hit_rate")
+        .desc("Translation cache hit rate")
+        ;
+    tcHitRate = tcHits / (tcHits + tcMisses);
+}
+
+Addr
+PagedTagAddrMapper::remapAddr(Addr addr, uint16_t DSid) const
+{
+    Addr remapped;
+    if (!translate(addr, DSid, remapped))
+        panic("%s: DSid#%d 0x%x is unmapped\n", name(), DSid, addr);
+    return remapped;
+}
+
+bool
+PagedTagAddrMapper::translate(Addr addr, uint16_t DSid,
+                              Addr &remapped) const
+{
+    // untagged or beyond the page tables, nothing is mapped for it
+    if (DSid >= maxDSids) {
+        unmappedAccesses++;
+        return false;
+    }
+
+    Addr gpn = addr >> pageShift;
+    Addr offset = addr & ((ULL(1) << pageShift) - 1);
+
+    TCEntry &entry = tcEntry(DSid, gpn);
+    if (entry.valid && entry.gpn == gpn) {
+        tcHits++;
+        remapped = (entry.mpn << pageShift) | offset;
+        return true;
+    }
+
+    tcMisses++;
+    const std::unordered_map<Addr, Addr> &table = pageTables[DSid];
+    auto it = table.find(gpn);
+    if (it == table.end()) {
+        unmappedAccesses++;
+        return false;
+    }
+
+    entry.gpn = gpn;
+    entry.mpn = it->second;
+    entry.valid = true;
+    remapped = (entry.mpn << pageShift) | offset;
+    return true;
+}
+
+void
+PagedTagAddrMapper::mapPage(uint16_t DSid, Addr gpa, Addr mpa)
+{
+    if (DSid >= maxDSids) {
+        warn("%s: DSid 0x%x out of page tables\n", name(), DSid);
+        return;
+    }
+
+    Addr gpn = gpa >> pageShift;
+    DPRINTF(TagAddrMapper, "DSid#%d: map page 0x%x ==> 0x%x\n",
+            DSid, gpn << pageShift, (mpa >> pageShift) << pageShift);
+
+    pageTables[DSid][gpn] = mpa >> pageShift;
+    TCEntry &entry = tcEntry(DSid, gpn);
+    if (entry.gpn == gpn)
+        entry.valid = false;
+}
+
+void
+PagedTagAddrMapper::unmapPage(uint16_t DSid, Addr gpa)
+{
+    if (DSid >= maxDSids)
+        return;
+
+    Addr gpn = gpa >> pageShift;
+    DPRINTF(TagAddrMapper, "DSid#%d: unmap page 0x%x\n",
+            DSid, gpn << pageShift);
+
+    pageTables[DSid].erase(gpn);
+    TCEntry &entry = tcEntry(DSid, gpn);
+    if (entry.gpn == gpn)
+        entry.valid = false;
+}
+
+void
+PagedTagAddrMapper::unmapAll(uint16_t DSid)
+{
+    if (DSid >= maxDSids)
+        return;
+
+    DPRINTF(TagAddrMapper, "DSid#%d: unmap all %d pages\n",
+            DSid, pageTables[DSid].size());
+
+    pageTables[DSid].clear();
+    for (unsigned i = 0; i < tcEntries; i++)
+        tc[DSid * tcEntries + i].valid = false;
+}
+
+bool
+PagedTagAddrMapper::handleCommand(int cmd, uint64_t arg1, uint64_t arg2,
+                                  uint64_t arg3)
+{
+    uint16_t DSid = (uint16_t)arg1;
+
+    if (cmd == 'P') {           // map page
+        mapPage(DSid, arg2 << pageShift, arg3);
+    } else if (cmd == 'U') {    // unmap page(s)
+        if (arg2 == 0xFFFFFFFF)
+            unmapAll(DSid);
+        else
+            unmapPage(DSid, arg2 << pageShift);
+    } else {
+        return false;
+    }
+
+    return true;
+}
+
+PagedTagAddrMapper *
+PagedTagAddrMapperParams::create()
+{
+    return new PagedTagAddrMapper(this);
+}
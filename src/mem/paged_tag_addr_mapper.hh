@@ -0,0 +1,122 @@
+/*
+ * Copyright (c) 2014 Institute of Computing Technology, CAS
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met: redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer;
+ * redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution;
+ * neither the name of the copyright holders nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Authors: Jiuyue Ma
+ */
+
+/**
+ * @file
+ * Declaration of a page-granular DSid address mapper.
+ */
+
+#ifndef __MEM_PAGED_TAG_ADDR_MAPPER_HH__
+#define __MEM_PAGED_TAG_ADDR_MAPPER_HH__
+
+#include <unordered_map>
+#include <vector>
+
+#include "base/statistics.hh"
+#include "mem/tag_addr_mapper.hh"
+#include "params/PagedTagAddrMapper.hh"
+#include "prm/interfaces.hh"
+
+/**
+ * Nested-paging style mapper: each DSid owns a page table mapping
+ * guest physical pages to machine pages, so LDom memory needs not be
+ * contiguous and can be resized page by page. Accesses to unmapped
+ * pages, untagged ones and those of a DSid beyond max_dsids included,
+ * are answered with a BadAddress error; snoops to them are dropped.
+ * Nothing is passed through untranslated.
+ *
+ * Translations are looked up in a small direct-mapped translation
+ * cache of the DSid first, the page table (a hash map) is only
+ * walked on a miss.
+ *
+ * Page tables are programmed through the control plane commands:
+ *   'P' map:   LDomID = DSid, DestAddr = guest page number,
+ *              Data = machine address of the page
+ *   'U' unmap: LDomID = DSid, DestAddr = guest page number, or
+ *              0xFFFFFFFF to unmap all pages of the DSid
+ */
+class PagedTagAddrMapper : public TagAddrMapper, public ICommandHandler
+{
+  public:
+
+    PagedTagAddrMapper(const PagedTagAddrMapperParams *p);
+
+    virtual ~PagedTagAddrMapper() { }
+
+    virtual AddrRangeList getAddrRanges() const { return ranges; }
+
+    virtual void regStats();
+
+    /**
+     * Page table interface, addresses are truncated to page boundary.
+     */
+    void mapPage(uint16_t DSid, Addr gpa, Addr mpa);
+    void unmapPage(uint16_t DSid, Addr gpa);
+    void unmapAll(uint16_t DSid);
+
+    // __override__ ICommandHandler::handleCommand()
+    virtual bool handleCommand(int cmd, uint64_t arg1, uint64_t arg2,
+                               uint64_t arg3);
+
+  protected:
+
+    virtual Addr remapAddr(Addr addr, uint16_t DSid) const;
+    virtual bool translate(Addr addr, uint16_t DSid, Addr &remapped) const;
+
+  private:
+
+    struct TCEntry {
+        Addr gpn;
+        Addr mpn;
+        bool valid;
+    };
+
+    AddrRangeList ranges;
+
+    const unsigned pageShift;
+    const unsigned maxDSids;
+    const unsigned tcEntries;
+
+    /** Page table of each DSid, guest page number ==> machine page number */
+    std::vector<std::unordered_map<Addr, Addr> > pageTables;
+
+    /** Translation caches, tcEntries entries per DSid */
+    mutable std::vector<TCEntry> tc;
+
+    TCEntry &tcEntry(uint16_t DSid, Addr gpn) const
+    { return tc[DSid * tcEntries + (gpn & (tcEntries - 1))]; }
+
+    mutable Stats::Scalar tcHits;
+    mutable Stats::Scalar tcMisses;
+    mutable Stats::Scalar unmappedAccesses;
+    Stats::Formula tcHitRate;
+};
+
+#endif //__MEM_PAGED_TAG_ADDR_MAPPER_HH__
@@ -0,0 +1,109 @@
+#include <algorithm>
+
+#include "debug/PARDCache.hh"
+#include "mem/cache/cache_impl.hh"
+#include "mem/pard_cache.hh"
+
+// PARDCache is the only user of Cache<PARDLRU>
+template class Cache<PARDLRU>;
+
+PARDCache::PARDCache(const Params *p)
+    : Cache<PARDLRU>(p), cp(p->cp),
+      pardPrefetcher(dynamic_cast<PARDStridePrefetcher *>(prefetcher)),
+      repartitionEpoch(p->repartition_epoch),
+      minWaysUnmet(false),
+      repartitionEvent(this)
+{
+    fatal_if(!tags, "%s: tags must be PARDLRU\n", name());
+
+    // replace the ports created by Cache<PARDLRU> with the DSid aware
+    // ones, nothing is bound to them yet
+    delete cpuSidePort;
+    delete memSidePort;
+    cpuSidePort = new PARDCpuSidePort(p->name + ".cpu_side", this,
+                                      "CpuSidePort");
+    memSidePort = new PARDMemSidePort(p->name + ".mem_side", this,
+                                      "MemSidePort");
+
+    tags->setControlPlane(cp);
+    if (pardPrefetcher)
+        pardPrefetcher->setControlPlane(cp);
+    else if (prefetcher)
+        warn("%s: prefetcher is not DSid aware, prefetches are not "
+             "accounted to any DSid\n", name());
+    if (repartitionEpoch)
+        tags->enableUMON(p->umon_sample_interval);
+    cp->regPARDCache(this);
+}
+
+void
+PARDCache::tagPrefetches(uint16_t DSid)
+{
+    if (pardPrefetcher) {
+        unsigned tagged = pardPrefetcher->tagPending(DSid);
+        if (tagged)
+            cp->recordPrefetchIssued(DSid, tagged);
+    }
+}
+
+void
+PARDCache::startup()
+{
+    Cache<PARDLRU>::startup();
+
+    if (repartitionEpoch)
+        schedule(repartitionEvent, curTick() + repartitionEpoch);
+}
+
+void
+PARDCache::repartition()
+{
+    UtilityMonitor *umon = tags->getUMON();
+    std::vector<UtilityMonitor::Demand> demands = cp->getDemands();
+    unsigned assoc = tags->getAssoc();
+
+    // without auto_partition the monitor keeps collecting, the way
+    // masks are up to the control plane
+    if (!cp->autoPartition() || demands.empty()) {
+        schedule(repartitionEvent, curTick() + repartitionEpoch);
+        return;
+    }
+
+    if (demands.size() > assoc) {
+        warn("%s: %d DSids do not fit in %d ways, skip repartition\n",
+             name(), demands.size(), assoc);
+    } else {
+        // minimums are served in the order of the param table, warn
+        // once when the later ones stop getting theirs
+        unsigned min_sum = 0;
+        for (auto &demand : demands)
+            min_sum += std::max(demand.minWays, 1U);
+        if (min_sum > assoc && !minWaysUnmet)
+            warn("%s: min_ways of %d DSids add up to %d ways, more than "
+                 "%d, later rows get less than their minimum\n",
+                 name(), demands.size(), min_sum, assoc);
+        minWaysUnmet = min_sum > assoc;
+
+        // hand out contiguous ways in the order of the param table
+        std::vector<unsigned> ways = umon->partition(demands);
+        unsigned start = 0;
+        for (size_t i = 0; i < demands.size(); i++) {
+            uint64_t mask = (ways[i] >= 64) ? ~0ULL : ((1ULL << ways[i]) - 1);
+            mask <<= start;
+            start += ways[i];
+
+            DPRINTF(PARDCache, "DSid#%d: %d ways, waymask 0x%x\n",
+                    demands[i].DSid, ways[i], mask);
+            cp->applyWayMask(demands[i].DSid, mask);
+        }
+        umon->decay();
+    }
+
+    schedule(repartitionEvent, curTick() + repartitionEpoch);
+}
+
+PARDCache *
+PARDCacheParams::create()
+{
+    return new PARDCache(this);
+}
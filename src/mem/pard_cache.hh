@@ -0,0 +1,105 @@
+#ifndef __MEM_PARD_CACHE_HH__
+#define __MEM_PARD_CACHE_HH__
+
+#include "mem/cache/cache.hh"
+#include "mem/pard_cache_cp.hh"
+#include "mem/pard_cache_tags.hh"
+#include "mem/pard_prefetcher.hh"
+#include "params/PARDCache.hh"
+
+/**
+ * Way-partitioned PARD cache, meant as the last-level cache.
+ *
+ * Same as Cache<LRU>, except that its ports tell the PARDLRU tags the
+ * DSid of each packet before the cache looks it up, so replacement
+ * obeys the way mask of that DSid and hits/misses/occupancy are
+ * accounted to it in the PARDCacheCP tables. Blocks filled by a
+ * response are owned by the DSid of the response. Prefetches queued
+ * by a PARDStridePrefetcher while handling a request are given the
+ * DSid of that request.
+ *
+ * With a non-zero repartition_epoch, the tags run a UtilityMonitor
+ * and the way masks of the DSids in the control plane are recomputed
+ * from it every epoch while auto_partition is set.
+ */
+class PARDCache : public Cache<PARDLRU>
+{
+  protected:
+
+    class PARDCpuSidePort : public CpuSidePort
+    {
+        PARDCache &pcache;
+
+      public:
+        PARDCpuSidePort(const std::string &_name, PARDCache *_cache,
+                        const std::string &_label)
+            : CpuSidePort(_name, _cache, _label), pcache(*_cache)
+        { }
+
+      protected:
+        // pkt may be gone once the cache has handled it
+        virtual bool recvTimingReq(PacketPtr pkt)
+        {
+            uint16_t DSid = pkt->getDSid();
+            pcache.setCurrentDSid(DSid);
+            bool success = CpuSidePort::recvTimingReq(pkt);
+            pcache.tagPrefetches(DSid);
+            return success;
+        }
+
+        virtual Tick recvAtomic(PacketPtr pkt)
+        {
+            uint16_t DSid = pkt->getDSid();
+            pcache.setCurrentDSid(DSid);
+            Tick latency = CpuSidePort::recvAtomic(pkt);
+            pcache.tagPrefetches(DSid);
+            return latency;
+        }
+    };
+
+    class PARDMemSidePort : public MemSidePort
+    {
+        PARDCache &pcache;
+
+      public:
+        PARDMemSidePort(const std::string &_name, PARDCache *_cache,
+                        const std::string &_label)
+            : MemSidePort(_name, _cache, _label), pcache(*_cache)
+        { }
+
+      protected:
+        virtual bool recvTimingResp(PacketPtr pkt)
+        {
+            pcache.setCurrentDSid(pkt->getDSid());
+            return MemSidePort::recvTimingResp(pkt);
+        }
+    };
+
+    PARDCacheCP *cp;
+
+    PARDStridePrefetcher *pardPrefetcher;
+
+    const Tick repartitionEpoch;
+
+    /** min_ways of the DSids exceeded assoc at the last repartition */
+    bool minWaysUnmet;
+
+    void repartition();
+    EventWrapper<PARDCache, &PARDCache::repartition> repartitionEvent;
+
+    void setCurrentDSid(uint16_t DSid)
+    { tags->setCurrentDSid(DSid); }
+
+    void tagPrefetches(uint16_t DSid);
+
+  public:
+    typedef PARDCacheParams Params;
+    PARDCache(const Params *p);
+
+    virtual void startup();
+
+    PARDLRU *getTags() const { return tags; }
+    bool canRepartition() const { return repartitionEpoch != 0; }
+};
+
+#endif	// __MEM_PARD_CACHE_HH__
@@ -0,0 +1,327 @@
+#include <algorithm>
+#include <cstddef>
+
+#include "debug/ControlPlane.hh"
+#include "mem/pard_cache.hh"
+#include "mem/pard_cache_cp.hh"
+
+// prefetches per accuracy window
+#define PF_WINDOW_SIZE		256
+
+PARDCacheCP::PARDCacheCP(const Params *p)
+    : ControlPlane(p),
+      param_table_entries(p->param_table_entries),
+      stat_table_entries(p->stat_table_entries),
+      dsidIndex(p->param_table_entries),
+      pfWindow(p->param_table_entries),
+      cache(NULL)
+{
+    panic_if(stat_table_entries < param_table_entries,
+             "%s: stat table (%d) smaller than param table (%d)\n",
+             name(), stat_table_entries, param_table_entries);
+
+    memset(&cacheInfo, 0, sizeof(cacheInfo));
+
+    // Allocate ConfigTable
+    paramTable = new struct CacheParamEntry[param_table_entries];
+    statTable  = new struct CacheStatEntry[stat_table_entries];
+    memset(paramTable, 0, sizeof(struct CacheParamEntry)*param_table_entries);
+    memset(statTable,  0, sizeof(struct CacheStatEntry) *stat_table_entries);
+}
+
+PARDCacheCP::~PARDCacheCP()
+{
+    delete[] paramTable;
+    delete[] statTable;
+}
+
+void
+PARDCacheCP::regPARDCache(PARDCache *_cache)
+{
+    panic_if(cache, "%s already reg to %s\n",
+             name().c_str(), cache->name().c_str());
+    cache = _cache;
+
+    cacheInfo.ways = cache->getTags()->getAssoc();
+    cacheInfo.sets = cache->getTags()->getNumSets();
+    cacheInfo.block_size = cache->getBlockSize();
+    cacheInfo.auto_partition = cache->canRepartition();
+}
+
+int
+PARDCacheCP::findTableRow(uint16_t DSid) const
+{
+    return dsidIndex.find(DSid);
+}
+
+CacheStatEntry *
+PARDCacheCP::getStatEntry(uint16_t DSid)
+{
+    int row = findTableRow(DSid);
+    return (row < 0) ? NULL : &statTable[row];
+}
+
+void
+PARDCacheCP::recordHit(uint16_t DSid, unsigned count)
+{
+    CacheStatEntry *stat = getStatEntry(DSid);
+    if (stat)
+        stat->hit_count += count;
+}
+
+void
+PARDCacheCP::recordMiss(uint16_t DSid, unsigned count)
+{
+    CacheStatEntry *stat = getStatEntry(DSid);
+    if (stat)
+        stat->miss_count += count;
+}
+
+void
+PARDCacheCP::recordEvictedByOther(uint16_t DSid, unsigned count)
+{
+    CacheStatEntry *stat = getStatEntry(DSid);
+    if (stat)
+        stat->evicted_by_other += count;
+}
+
+void
+PARDCacheCP::recordPrefetchIssued(uint16_t DSid, unsigned count)
+{
+    int row = findTableRow(DSid);
+    if (row < 0)
+        return;
+
+    statTable[row].pf_issued += count;
+
+    PrefetchWindow &window = pfWindow[row];
+    window.issued += count;
+    if (window.issued >= PF_WINDOW_SIZE) {
+        window.issued /= 2;
+        window.useful /= 2;
+    }
+}
+
+void
+PARDCacheCP::recordPrefetchUseful(uint16_t DSid)
+{
+    int row = findTableRow(DSid);
+    if (row < 0)
+        return;
+
+    statTable[row].pf_useful++;
+    pfWindow[row].useful++;
+}
+
+unsigned
+PARDCacheCP::prefetchDegree(uint16_t DSid, unsigned degree) const
+{
+    int row = findTableRow(DSid);
+    if (row < 0)
+        return degree;
+
+    const CacheParamEntry &entry = paramTable[row];
+    if (entry.pf_disable)
+        return 0;
+    if (entry.pf_degree)
+        degree = std::min<uint64_t>(degree, entry.pf_degree);
+
+    // inaccurate DSids keep one prefetch so that accuracy can recover
+    const PrefetchWindow &window = pfWindow[row];
+    if (entry.pf_min_accuracy && window.issued >= PF_WINDOW_SIZE / 2 &&
+        window.useful * 10000 < entry.pf_min_accuracy * window.issued)
+        degree = std::min(degree, 1U);
+
+    return degree;
+}
+
+std::vector<UtilityMonitor::Demand>
+PARDCacheCP::getDemands() const
+{
+    std::vector<UtilityMonitor::Demand> demands;
+    for (int i=0; i<param_table_entries; i++) {
+        if (paramTable[i].flags & CACHE_FLAG_VALID) {
+            UtilityMonitor::Demand d;
+            d.DSid = paramTable[i].DSid;
+            d.minWays = paramTable[i].min_ways;
+            d.weight = paramTable[i].weight ? paramTable[i].weight : 1;
+            demands.push_back(d);
+        }
+    }
+    return demands;
+}
+
+void
+PARDCacheCP::applyWayMask(uint16_t DSid, uint64_t mask)
+{
+    int row = findTableRow(DSid);
+    if (row < 0)
+        return;
+
+    paramTable[row].waymask = mask;
+    if (cache)
+        cache->getTags()->setWayMask(DSid, mask);
+}
+
+void
+PARDCacheCP::paramUpdated(int row, const CacheParamEntry &old)
+{
+    CacheParamEntry &entry = paramTable[row];
+    bool was_valid = old.flags & CACHE_FLAG_VALID;
+    bool is_valid = entry.flags & CACHE_FLAG_VALID;
+
+    dsidIndex.set(row, is_valid ? entry.DSid : -1);
+
+    // (re)bind statistics row to this DSid
+    if (is_valid && (!was_valid || old.DSid != entry.DSid)) {
+        memset(&statTable[row], 0, sizeof(struct CacheStatEntry));
+        statTable[row].DSid = entry.DSid;
+        statTable[row].flags = CACHE_FLAG_VALID;
+        pfWindow[row].issued = pfWindow[row].useful = 0;
+    } else if (!is_valid) {
+        statTable[row].flags &= ~CACHE_FLAG_VALID;
+    }
+
+    if (!cache)
+        return;
+
+    // withdraw or (re)program way mask
+    if (was_valid && (!is_valid || old.DSid != entry.DSid))
+        cache->getTags()->setWayMask(old.DSid, 0);
+    if (is_valid) {
+        if (entry.waymask && !(entry.waymask & ((cacheInfo.ways >= 64) ?
+                ~0ULL : ((1ULL << cacheInfo.ways) - 1))))
+            warn("PARDCacheCP: waymask 0x%x of DSid#%d has no way in "
+                 "%d-way cache, use all ways", entry.waymask, entry.DSid,
+                 cacheInfo.ways);
+        cache->getTags()->setWayMask(entry.DSid, entry.waymask);
+    }
+}
+
+void
+PARDCacheCP::updateCacheInfo(unsigned offset, uint64_t data)
+{
+    if (offset == offsetof(CacheInfo, auto_partition)) {
+        if (data && !(cache && cache->canRepartition())) {
+            warn("PARDCacheCP: auto_partition needs repartition_epoch");
+            return;
+        }
+        cacheInfo.auto_partition = data ? 1 : 0;
+    } else {
+        warn("PARDCacheCP: sysinfo offset 0x%x is read-only", offset);
+    }
+}
+
+uint64_t *
+PARDCacheCP::parseAddr(uint32_t addr)
+{
+    char *ptr = NULL;
+    int offset;
+
+    switch (addr & ADDRTYPE_MASK)
+    {
+      case ADDRTYPE_CFGTBL:
+        {
+            int row = cfgtbl_addr2row(addr);
+            offset = cfgtbl_addr2offset(addr);
+
+            switch (cfgtbl_addr2type(addr)) {
+              case CFGTBL_TYPE_PARAM:
+                if ((row < param_table_entries) &&
+                    (offset <= sizeof(struct CacheParamEntry) - sizeof(uint64_t)))
+                    ptr = (char *)&paramTable[row];
+                break;
+              case CFGTBL_TYPE_STAT:
+                if ((row < stat_table_entries) &&
+                    (offset <= sizeof(struct CacheStatEntry) - sizeof(uint64_t)))
+                    ptr = (char *)&statTable[row];
+                break;
+            }
+        }
+        break;
+      case ADDRTYPE_SYSINFO:
+        offset = sysinfo_addr2offset(addr);
+        if (offset <= sizeof(cacheInfo) - sizeof(uint64_t))
+            ptr = (char *)&cacheInfo;
+        break;
+    }
+
+    return (ptr ? ((uint64_t *)(ptr + offset)) : NULL);
+}
+
+uint64_t
+PARDCacheCP::queryTable(uint16_t DSid, uint32_t addr)
+{
+    uint64_t *pdata;
+
+    DPRINTF(ControlPlane, "queryTable(DSid=%d, addr=0x%x)\n",
+            DSid, addr);
+
+    if (isTriggerAddr(addr))
+        return queryTrigger(addr);
+
+    pdata = parseAddr(addr);
+    if (!pdata) {
+        warn("PARDCacheCP: unknown addr 0x%x", addr);
+        return 0xFFFFFFFFFFFFFFFF;
+    }
+
+    // occupancy is kept by the tags, refresh it and mpkr on query
+    if ((addr & ADDRTYPE_MASK) == ADDRTYPE_CFGTBL &&
+        cfgtbl_addr2type(addr) == CFGTBL_TYPE_STAT && cache) {
+        CacheStatEntry &stat = statTable[cfgtbl_addr2row(addr)];
+        if (stat.flags & CACHE_FLAG_VALID) {
+            uint64_t requests = stat.hit_count + stat.miss_count;
+            stat.capacity = cache->getTags()->getOccupancy(stat.DSid) *
+                            cacheInfo.block_size;
+            stat.mpkr = requests ? stat.miss_count * 1000 / requests : 0;
+            stat.pf_accuracy = stat.pf_issued ?
+                stat.pf_useful * 10000 / stat.pf_issued : 0;
+        }
+    }
+
+    return *pdata;
+}
+
+void
+PARDCacheCP::updateTable(uint16_t DSid, uint32_t addr, uint64_t data)
+{
+    uint64_t *pdata;
+
+    DPRINTF(ControlPlane, "updateTable(DSid=%d, addr=0x%x, data=0x%x)\n",
+            DSid, addr, data);
+
+    if (isTriggerAddr(addr)) {
+        updateTrigger(addr, data);
+        return;
+    }
+
+    pdata = parseAddr(addr);
+    if (!pdata) {
+        warn("PARDCacheCP: unknown addr 0x%x", addr);
+        return;
+    }
+
+    if ((addr & ADDRTYPE_MASK) == ADDRTYPE_SYSINFO) {
+        updateCacheInfo(sysinfo_addr2offset(addr), data);
+        return;
+    }
+
+    // only parameter table is writable
+    if ((addr & ADDRTYPE_MASK) != ADDRTYPE_CFGTBL ||
+        cfgtbl_addr2type(addr) != CFGTBL_TYPE_PARAM) {
+        warn("PARDCacheCP: addr 0x%x is read-only", addr);
+        return;
+    }
+
+    int row = cfgtbl_addr2row(addr);
+    CacheParamEntry old = paramTable[row];
+    *pdata = data;
+    paramUpdated(row, old);
+}
+
+PARDCacheCP *
+PARDCacheCPParams::create()
+{
+    return new PARDCacheCP(this);
+}
@@ -0,0 +1,151 @@
+/**
+ * PARDg5-V Cache Control Plane
+ *
+ * Uses the same ConfigTable/SystemInfo address mapping as
+ * PARDg5VSystemCP (see arch/x86/pardg5v_system_cp.hh). Row #i of the
+ * statistics table holds the counters of the DSid in row #i of the
+ * parameter table; it is reset when the parameter row becomes valid.
+ *
+ * waymask restricts the ways the DSid may replace (bit i is way i),
+ * 0 means all ways. capacity is the number of bytes currently filled
+ * by the DSid, mpkr is misses per 1000 requests, both are computed on
+ * query. evicted_by_other counts blocks of the DSid replaced by a fill
+ * of another DSid. With monitor_sample_interval of the tags above 1,
+ * all statistics are estimated from the sampled sets.
+ *
+ * Prefetches of a PARDStridePrefetcher inherit the DSid of the request
+ * that triggered them. pf_disable turns them off for the DSid, a
+ * non-zero pf_degree caps the prefetches per request, and while the
+ * recent accuracy (useful / issued prefetches) of the DSid is below
+ * pf_min_accuracy (in 0.01% units, 0 means no limit) it only gets one
+ * prefetch per request. pf_accuracy is computed on query.
+ *
+ * When auto_partition is set in SystemInfo (writable, only if the
+ * cache has a repartition_epoch), PARDCache rewrites waymask of every
+ * valid row each epoch from its utility monitor, giving each DSid at
+ * least min_ways ways and sharing the rest by weighted hits (weight 0
+ * counts as 1). The rest of SystemInfo is read-only.
+ */
+
+#ifndef __MEM_PARD_CACHE_CP_HH__
+#define __MEM_PARD_CACHE_CP_HH__
+
+#include <vector>
+
+#include "mem/pard_umon.hh"
+#include "params/PARDCacheCP.hh"
+#include "prm/ControlPlane.hh"
+#include "prm/DSidIndex.hh"
+
+#define CACHE_FLAG_VALID	0x8000
+
+struct CacheParamEntry {
+    uint16_t DSid;
+    uint16_t flags;
+    uint32_t __padding;
+    uint64_t waymask;
+    uint64_t min_ways;
+    uint64_t weight;
+    uint64_t pf_disable;
+    uint64_t pf_degree;
+    uint64_t pf_min_accuracy;
+};
+
+struct CacheStatEntry {
+    uint16_t DSid;
+    uint16_t flags;
+    uint32_t __padding;
+    // same layout as CPA_CACHE_IOCADDR
+    uint64_t capacity;
+    uint64_t hit_count;
+    uint64_t miss_count;
+    uint64_t mpkr;
+    uint64_t evicted_by_other;
+    uint64_t pf_issued;
+    uint64_t pf_useful;
+    uint64_t pf_accuracy;
+};
+
+struct CacheInfo {
+    uint64_t ways;
+    uint64_t sets;
+    uint64_t block_size;
+    uint64_t auto_partition;    // writable
+};
+
+class PARDCache;
+
+class PARDCacheCP : public ControlPlane
+{
+  protected:
+    int param_table_entries;
+    int stat_table_entries;
+
+    struct CacheParamEntry *paramTable;
+    struct CacheStatEntry  *statTable;
+    struct CacheInfo cacheInfo;
+    DSidIndex dsidIndex;
+
+    // recent prefetch accuracy of each param row, aged by halving
+    struct PrefetchWindow {
+        uint64_t issued;
+        uint64_t useful;
+    };
+    std::vector<PrefetchWindow> pfWindow;
+
+    PARDCache *cache;
+
+  public:
+    typedef PARDCacheCPParams Params;
+    PARDCacheCP(const Params *p);
+    ~PARDCacheCP();
+
+    void regPARDCache(PARDCache *_cache);
+
+  public:
+    CacheStatEntry *getStatEntry(uint16_t DSid);
+
+    /**
+     * Statistics interface, called by PARDLRU tags.
+     */
+    void recordHit(uint16_t DSid, unsigned count);
+    void recordMiss(uint16_t DSid, unsigned count);
+    void recordEvictedByOther(uint16_t DSid, unsigned count);
+    void recordPrefetchIssued(uint16_t DSid, unsigned count);
+    void recordPrefetchUseful(uint16_t DSid);
+
+    /**
+     * Prefetch control, called by PARDStridePrefetcher.
+     *
+     * @param degree number of prefetches calculated for the request
+     * @return number of prefetches DSid may issue
+     */
+    unsigned prefetchDegree(uint16_t DSid, unsigned degree) const;
+
+    /**
+     * Repartitioning interface, called by PARDCache.
+     */
+    bool autoPartition() const { return cacheInfo.auto_partition; }
+    std::vector<UtilityMonitor::Demand> getDemands() const;
+    void applyWayMask(uint16_t DSid, uint64_t mask);
+
+    virtual uint64_t queryTable(uint16_t DSid, uint32_t addr);
+    virtual void updateTable(uint16_t DSid, uint32_t addr, uint64_t data);
+
+  protected:
+    virtual int findTableRow(uint16_t DSid) const;
+    virtual size_t statEntrySize() const
+    { return sizeof(struct CacheStatEntry); }
+    virtual int statTableEntries() const { return stat_table_entries; }
+
+  private:
+    uint64_t *parseAddr(uint32_t addr);
+    void paramUpdated(int row, const CacheParamEntry &old);
+    void updateCacheInfo(unsigned offset, uint64_t data);
+
+  protected:
+    const Params *param() const
+    { return dynamic_cast<const Params *>(_params); }
+};
+
+#endif	// __MEM_PARD_CACHE_CP_HH__
@@ -0,0 +1,160 @@
+#include <cassert>
+
+#include "base/intmath.hh"
+#include "base/misc.hh"
+#include "debug/CacheRepl.hh"
+#include "mem/pard_cache_cp.hh"
+#include "mem/pard_cache_tags.hh"
+
+PARDLRU::PARDLRU(const Params *p)
+    : LRU(p), cp(NULL), curDSid(0), umon(NULL),
+      monitorInterval(p->monitor_sample_interval ?
+                      p->monitor_sample_interval : 1),
+      allWays(assoc >= 64 ? ~0ULL : ((1ULL << assoc) - 1)),
+      blkOwner(divCeil(numSets, monitorInterval) * assoc, -1)
+{
+}
+
+PARDLRU::~PARDLRU()
+{
+    delete umon;
+}
+
+void
+PARDLRU::enableUMON(unsigned sample_interval)
+{
+    if (!umon)
+        umon = new UtilityMonitor(assoc, sample_interval);
+}
+
+void
+PARDLRU::setWayMask(uint16_t DSid, uint64_t mask)
+{
+    mask &= allWays;
+    if (mask && mask != allWays)
+        wayMasks[DSid] = mask;
+    else
+        wayMasks.erase(DSid);
+}
+
+uint64_t
+PARDLRU::getWayMask(uint16_t DSid) const
+{
+    auto it = wayMasks.find(DSid);
+    return (it == wayMasks.end()) ? allWays : it->second;
+}
+
+uint64_t
+PARDLRU::getOccupancy(uint16_t DSid) const
+{
+    auto it = occupancy.find(DSid);
+    return (it == occupancy.end()) ? 0 : it->second * monitorInterval;
+}
+
+int
+PARDLRU::ownerIndex(const BlkType *blk) const
+{
+    int idx = blk - blks;
+    int set = idx / assoc;
+    if (!monitored(set))
+        return -1;
+    return (set / monitorInterval) * assoc + idx % assoc;
+}
+
+PARDLRU::BlkType*
+PARDLRU::accessBlock(Addr addr, bool is_secure, Cycles &lat,
+                     int context_src)
+{
+    BlkType *blk = LRU::accessBlock(addr, is_secure, lat, context_src);
+    int set = extractSet(addr);
+
+    if (umon && umon->sampled(set))
+        umon->access(curDSid, set, extractTag(addr));
+
+    // prefetch accuracy is needed per request, not sampled
+    if (cp && blk && blk->wasPrefetched())
+        cp->recordPrefetchUseful(curDSid);
+
+    if (cp && monitored(set)) {
+        if (blk)
+            cp->recordHit(curDSid, monitorInterval);
+        else
+            cp->recordMiss(curDSid, monitorInterval);
+    }
+
+    return blk;
+}
+
+PARDLRU::BlkType*
+PARDLRU::findVictim(Addr addr) const
+{
+    uint64_t mask = getWayMask(curDSid);
+    if (mask == allWays)
+        return LRU::findVictim(addr);
+
+    // blks of a set are kept in MRU order, walk from the LRU end and
+    // prefer a free block in the partition
+    int set = extractSet(addr);
+    BlkType *victim = NULL;
+    for (int i = assoc - 1; i >= 0; i--) {
+        BlkType *blk = sets[set].blks[i];
+        if (!(mask & (1ULL << wayOf(blk))))
+            continue;
+        if (!blk->isValid())
+            return blk;
+        if (!victim)
+            victim = blk;
+    }
+
+    assert(victim);
+    DPRINTF(CacheRepl, "set %x: DSid#%d selecting blk %x for replacement\n",
+            set, curDSid, regenerateBlkAddr(victim->tag, set));
+    return victim;
+}
+
+void
+PARDLRU::releaseBlock(int idx)
+{
+    int &owner = blkOwner[idx];
+    if (owner >= 0) {
+        auto it = occupancy.find(owner);
+        assert(it != occupancy.end() && it->second > 0);
+        if (--it->second == 0)
+            occupancy.erase(it);
+        owner = -1;
+    }
+}
+
+void
+PARDLRU::insertBlock(PacketPtr pkt, BlkType *blk)
+{
+    int idx = ownerIndex(blk);
+    if (idx >= 0) {
+        int owner = blkOwner[idx];
+        if (cp && blk->isValid() && owner >= 0 && owner != curDSid)
+            cp->recordEvictedByOther(owner, monitorInterval);
+        releaseBlock(idx);
+    }
+
+    LRU::insertBlock(pkt, blk);
+
+    if (idx >= 0) {
+        blkOwner[idx] = curDSid;
+        occupancy[curDSid]++;
+    }
+}
+
+void
+PARDLRU::invalidate(BlkType *blk)
+{
+    int idx = ownerIndex(blk);
+    if (idx >= 0)
+        releaseBlock(idx);
+    LRU::invalidate(blk);
+}
+
+PARDLRU *
+PARDLRUParams::create()
+{
+    return new PARDLRU(this);
+}
@@ -0,0 +1,86 @@
+#ifndef __MEM_PARD_CACHE_TAGS_HH__
+#define __MEM_PARD_CACHE_TAGS_HH__
+
+#include <unordered_map>
+#include <vector>
+
+#include "mem/cache/tags/lru.hh"
+#include "mem/pard_umon.hh"
+#include "params/PARDLRU.hh"
+
+class PARDCacheCP;
+
+/**
+ * LRU tags with per-DSid way partitioning.
+ *
+ * Tags have no access to the packet on lookup and replacement, the
+ * owning PARDCache sets the DSid of the access in progress with
+ * setCurrentDSid() before handing the packet to the cache.
+ *
+ * A DSid only replaces blocks in the ways of its way mask (bit i is
+ * way i, 0 means all ways), hits are still served from any way, so
+ * shrinking a mask takes effect as the other DSids evict the blocks.
+ *
+ * Per-DSid hits, misses, occupancy and evictions by another DSid are
+ * only accounted in one out of every monitor_sample_interval sets and
+ * scaled up by the interval, 1 accounts every block of the cache.
+ *
+ * With enableUMON() the accesses to sampled sets are also fed to a
+ * UtilityMonitor, which PARDCache uses to repartition the ways.
+ */
+class PARDLRU : public LRU
+{
+  public:
+    typedef PARDLRUParams Params;
+    PARDLRU(const Params *p);
+    ~PARDLRU();
+
+    void setControlPlane(PARDCacheCP *_cp) { cp = _cp; }
+    void setCurrentDSid(uint16_t DSid) { curDSid = DSid; }
+
+    void enableUMON(unsigned sample_interval);
+    UtilityMonitor *getUMON() const { return umon; }
+
+    void setWayMask(uint16_t DSid, uint64_t mask);
+    uint64_t getWayMask(uint16_t DSid) const;
+
+    /** Number of valid blocks filled by DSid, estimated if sampled */
+    uint64_t getOccupancy(uint16_t DSid) const;
+
+    unsigned getAssoc() const { return assoc; }
+    unsigned getNumSets() const { return numSets; }
+
+    BlkType* accessBlock(Addr addr, bool is_secure, Cycles &lat,
+                         int context_src);
+    BlkType* findVictim(Addr addr) const;
+    void insertBlock(PacketPtr pkt, BlkType *blk);
+    void invalidate(BlkType *blk);
+
+  private:
+    unsigned wayOf(const BlkType *blk) const
+    { return (blk - blks) % assoc; }
+
+    bool monitored(int set) const
+    { return set % monitorInterval == 0; }
+
+    /** Index of blk in blkOwner, -1 if its set is not monitored */
+    int ownerIndex(const BlkType *blk) const;
+
+    void releaseBlock(int idx);
+
+    PARDCacheCP *cp;
+    uint16_t curDSid;
+
+    UtilityMonitor *umon;
+
+    const unsigned monitorInterval;
+
+    const uint64_t allWays;
+    std::unordered_map<uint16_t, uint64_t> wayMasks;
+    std::unordered_map<uint16_t, uint64_t> occupancy;
+
+    /** DSid that filled each block of the monitored sets, -1 if none */
+    std::vector<int> blkOwner;
+};
+
+#endif	// __MEM_PARD_CACHE_TAGS_HH__
@@ -0,0 +1,58 @@
+#include "base/intmath.hh"
+#include "base/misc.hh"
+#include "mem/pard_decode_cache.hh"
+
+DecodeCache::DecodeCache(unsigned entries, Addr page_size)
+    : cache(entries), pageShift(0), indexMask(entries ? entries - 1 : 0)
+{
+    fatal_if(entries && !isPowerOf2(entries),
+             "decode cache entries (%d) must be a power of 2\n", entries);
+    fatal_if(!isPowerOf2(page_size),
+             "decode cache page size (%d) must be a power of 2\n",
+             page_size);
+    pageShift = floorLog2(page_size);
+    invalidate();
+}
+
+void
+DecodeCache::insert(Addr addr, const AddrRange &range, PortID port)
+{
+    if (!enabled() || range.interleaved())
+        return;
+
+    AddrRange page_range = pageOf(addr);
+    if (range.start() > page_range.start() || range.end() < page_range.end())
+        return;
+
+    Addr page = addr >> pageShift;
+    Entry &e = cache[page & indexMask];
+    e.page = page;
+    e.port = port;
+}
+
+void
+DecodeCache::invalidate()
+{
+    for (auto &e : cache)
+        e.port = InvalidPortID;
+}
+
+void
+DecodeCache::regStats(const std::string &name)
+{
+    using namespace Stats;
+
+    hits
+        .name(name + ".decode_hits")
+        .desc("Number of address decodes hit in decode cache")
+        ;
+    misses
+        .name(name + ".decode_misses")
+        .desc("Number of address decodes missed in decode cache")
+        ;
+    hitRate
+        .name(name + ".decode_hit_rate")
+        .desc("Hit rate of decode cache")
+        ;
+    hitRate = hits / (hits + misses);
+}
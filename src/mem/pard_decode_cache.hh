@@ -0,0 +1,76 @@
+#ifndef __MEM_PARD_DECODE_CACHE_HH__
+#define __MEM_PARD_DECODE_CACHE_HH__
+
+#include <string>
+#include <vector>
+
+#include "base/addr_range.hh"
+#include "base/statistics.hh"
+#include "base/types.hh"
+
+/**
+ * Direct-mapped cache of crossbar address decoding.
+ *
+ * Remembers the destination port of recently routed pages, so that
+ * back-to-back requests to the same page skip the AddrRangeMap walk.
+ * A page is only remembered if it lies entirely within the decoded,
+ * non-interleaved range, hence a hit always gives the same port as a
+ * full lookup. The owner must invalidate() it on any range change.
+ */
+class DecodeCache
+{
+  public:
+
+    /**
+     * @param entries number of entries, zero disables the cache
+     * @param page_size decoding granularity, must be a power of 2
+     */
+    DecodeCache(unsigned entries, Addr page_size);
+
+    bool enabled() const { return !cache.empty(); }
+
+    /** @return cached port of addr, or InvalidPortID on miss */
+    PortID lookup(Addr addr)
+    {
+        if (!enabled())
+            return InvalidPortID;
+
+        Addr page = addr >> pageShift;
+        const Entry &e = cache[page & indexMask];
+        if (e.port != InvalidPortID && e.page == page) {
+            hits++;
+            return e.port;
+        }
+        misses++;
+        return InvalidPortID;
+    }
+
+    /** Page of addr, at decoding granularity */
+    AddrRange pageOf(Addr addr) const
+    { return RangeSize(addr & ~((ULL(1) << pageShift) - 1),
+                       ULL(1) << pageShift); }
+
+    /** Remember the port of addr decoded through range */
+    void insert(Addr addr, const AddrRange &range, PortID port);
+
+    void invalidate();
+
+    void regStats(const std::string &name);
+
+  private:
+
+    struct Entry {
+        Addr page;
+        PortID port;
+    };
+
+    std::vector<Entry> cache;
+    unsigned pageShift;
+    Addr indexMask;
+
+    Stats::Scalar hits;
+    Stats::Scalar misses;
+    Stats::Formula hitRate;
+};
+
+#endif	// __MEM_PARD_DECODE_CACHE_HH__
@@ -0,0 +1,166 @@
+#include <cassert>
+
+#include "base/intmath.hh"
+#include "mem/pard_dram_shadow.hh"
+#include "params/DRAMCtrl.hh"
+#include "sim/core.hh"
+
+DRAMRowShadow::DRAMRowShadow(const AbstractMemory *mem)
+    : base(mem->getAddrRange().start())
+{
+    const DRAMCtrlParams *p =
+        dynamic_cast<const DRAMCtrlParams *>(mem->params());
+
+    if (p) {
+        _burstSize = (p->devices_per_rank * p->burst_length *
+                      p->device_bus_width) / 8;
+        _rowBufferSize = p->devices_per_rank * p->device_rowbuffer_size;
+        banksPerRank = p->banks_per_rank;
+        ranksPerChannel = p->ranks_per_channel;
+        channels = p->channels;
+        tBURST = p->tBURST;
+        tRCD = p->tRCD;
+        tCL = p->tCL;
+        tRP = p->tRP;
+
+        switch (p->addr_mapping) {
+          case Enums::RoRaBaChCo: mapping = RoRaBaChCo; break;
+          case Enums::RoRaBaCoCh: mapping = RoRaBaCoCh; break;
+          case Enums::RoCoRaBaCh: mapping = RoCoRaBaCh; break;
+          default:
+            panic("DRAMRowShadow: unknown address mapping of %s\n",
+                  mem->name());
+        }
+        closePage = (p->page_policy == Enums::close ||
+                     p->page_policy == Enums::close_adaptive);
+    } else {
+        warn("DRAMRowShadow: %s is not a DRAMCtrl, assume DDR3-1600 x64\n",
+             mem->name());
+        _burstSize = 64;
+        _rowBufferSize = 8192;
+        banksPerRank = 8;
+        ranksPerChannel = 2;
+        channels = 1;
+        tBURST = 5 * SimClock::Int::ns;
+        tRCD = 13750 * SimClock::Int::ps;
+        tCL = 13750 * SimClock::Int::ps;
+        tRP = 13750 * SimClock::Int::ps;
+        mapping = RoRaBaChCo;
+        closePage = false;
+    }
+
+    columnsPerRowBuffer = _rowBufferSize / _burstSize;
+
+    uint64_t capacity = ULL(1) << ceilLog2(mem->size());
+    rowsPerBank = capacity / (_rowBufferSize * banksPerRank * ranksPerChannel);
+    if (rowsPerBank == 0)
+        rowsPerBank = 1;
+
+    openRow.assign(banksPerRank * ranksPerChannel, NoRow);
+}
+
+void
+DRAMRowShadow::split(Addr addr, Addr *fields, Addr *byte_offset) const
+{
+    // Same decoding as DRAMCtrl::decodeAddr(), fields from LSB to MSB
+    static const Field order[][NumFields - 1] = {
+        { Column, Channel, Bank, Rank },    // RoRaBaChCo
+        { Channel, Column, Bank, Rank },    // RoRaBaCoCh
+        { Channel, Bank, Rank, Column },    // RoCoRaBaCh
+    };
+
+    Addr a = addr - base;
+    *byte_offset = a % _burstSize;
+    a = a / _burstSize;
+    for (int i = 0; i < NumFields - 1; i++) {
+        Field f = order[mapping][i];
+        fields[f] = a % radix(f);
+        a = a / radix(f);
+    }
+    fields[Row] = a;
+}
+
+Addr
+DRAMRowShadow::join(const Addr *fields, Addr byte_offset) const
+{
+    static const Field order[][NumFields - 1] = {
+        { Rank, Bank, Channel, Column },    // RoRaBaChCo
+        { Rank, Bank, Column, Channel },    // RoRaBaCoCh
+        { Column, Rank, Bank, Channel },    // RoCoRaBaCh
+    };
+
+    Addr a = fields[Row];
+    for (int i = 0; i < NumFields - 1; i++) {
+        Field f = order[mapping][i];
+        a = a * radix(f) + fields[f];
+    }
+    return base + a * _burstSize + byte_offset;
+}
+
+DRAMRowShadow::Coord
+DRAMRowShadow::decode(Addr addr) const
+{
+    Addr fields[NumFields];
+    Addr byte_offset;
+    split(addr, fields, &byte_offset);
+
+    Coord c;
+    c.bank = fields[Rank] * banksPerRank + fields[Bank];
+    c.row = fields[Row] % rowsPerBank;
+    return c;
+}
+
+Addr
+DRAMRowShadow::colorAddr(Addr addr, const BankColor &color) const
+{
+    Addr fields[NumFields];
+    Addr byte_offset;
+    split(addr, fields, &byte_offset);
+
+    // Low bits of the flat bank index pick one of the allowed banks,
+    // the remaining bits are moved into the row. Each addressed row
+    // spreads over numBanks/ways rows of the color, so the mapping is
+    // a bijection onto the rows of the color as long as the address
+    // is in its first numRows*ways/numBanks rows.
+    unsigned ways = color.banks.size();
+    Addr spread = numBanks() / ways;
+    Addr bank = fields[Rank] * banksPerRank + fields[Bank];
+    Addr colored = color.banks[bank % ways];
+    assert(color.numRows % spread == 0);
+    assert(fields[Row] >= color.firstRow &&
+           fields[Row] < color.firstRow + color.numRows / spread);
+    Addr row = color.firstRow + (fields[Row] - color.firstRow) * spread
+               + bank / ways;
+    assert(row < color.firstRow + color.numRows);
+
+    fields[Rank] = colored / banksPerRank;
+    fields[Bank] = colored % banksPerRank;
+    fields[Row] = row;
+    return join(fields, byte_offset);
+}
+
+bool
+DRAMRowShadow::isRowHit(Addr addr) const
+{
+    if (closePage)
+        return false;
+    Coord c = decode(addr);
+    return openRow[c.bank] == c.row;
+}
+
+bool
+DRAMRowShadow::access(Addr addr)
+{
+    Coord c = decode(addr);
+    bool hit = !closePage && openRow[c.bank] == c.row;
+    openRow[c.bank] = closePage ? NoRow : c.row;
+    return hit;
+}
+
+uint64_t
+DRAMRowShadow::peakBW() const
+{
+    if (tBURST == 0)
+        return 0;
+    return (uint64_t)((double)_burstSize * SimClock::Frequency / tBURST);
+}
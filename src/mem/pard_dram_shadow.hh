@@ -0,0 +1,124 @@
+#ifndef __MEM_PARD_DRAM_SHADOW_HH__
+#define __MEM_PARD_DRAM_SHADOW_HH__
+
+#include <vector>
+
+#include "mem/abstract_mem.hh"
+
+/**
+ * Shadow row-buffer model of the DRAM behind PARDMemoryCtrl.
+ *
+ * PARDMemoryCtrl only sees packets on their way to/from the DRAM
+ * controller, so it keeps its own copy of the open row of each bank to
+ * tell row hits from row misses. Geometry, address mapping and timing
+ * are taken from DRAMCtrl parameters when the internal memory is a
+ * DRAMCtrl, otherwise a DDR3-1600 x64 like default is assumed.
+ */
+class DRAMRowShadow
+{
+  public:
+
+    /** Decoded DRAM coordinates of an address */
+    struct Coord {
+        unsigned bank;      // flat bank index: rank * banksPerRank + bank
+        Addr row;
+    };
+
+    /**
+     * Bank coloring: addresses are restricted to the listed flat bank
+     * indices, the number of banks must be a power of two. The LDom
+     * holds rows [firstRow, firstRow+numRows) of every bank, of which
+     * the first numRows*ways/banks are addressed before coloring and
+     * all numRows of the listed banks after it.
+     */
+    struct BankColor {
+        std::vector<unsigned> banks;
+        Addr firstRow;
+        Addr numRows;
+    };
+
+    DRAMRowShadow(const AbstractMemory *mem);
+
+    /** Decode a memory-local address to (bank, row) */
+    Coord decode(Addr addr) const;
+
+    /**
+     * Move addr into the banks of color. The bank index bits select
+     * a bank of color and the surplus bits are shifted into the row,
+     * so the addressed rows of color map one-to-one onto all its rows
+     * of its banks.
+     */
+    Addr colorAddr(Addr addr, const BankColor &color) const;
+
+    /** Check whether access to addr would hit the open row */
+    bool isRowHit(Addr addr) const;
+
+    /** Access addr, return true on row hit, update open row */
+    bool access(Addr addr);
+
+    unsigned burstSize() const { return _burstSize; }
+    unsigned rowBufferSize() const { return _rowBufferSize; }
+    unsigned numBanks() const { return banksPerRank * ranksPerChannel; }
+    unsigned numChannels() const { return channels; }
+    Addr numRows() const { return rowsPerBank; }
+
+    /** Bytes covered by one row of every bank */
+    Addr rowStride() const
+    {
+        return (Addr)_rowBufferSize * channels * numBanks();
+    }
+
+    /** Number of bursts touched by [addr, addr+size) */
+    unsigned numBursts(Addr addr, unsigned size) const
+    {
+        Addr first = addr / _burstSize;
+        Addr last  = (addr + size - 1) / _burstSize;
+        return last - first + 1;
+    }
+
+    /** Peak bandwidth in bytes per second */
+    uint64_t peakBW() const;
+
+    Tick tBURST;
+    Tick tRCD;
+    Tick tCL;
+    Tick tRP;
+
+  private:
+
+    enum AddrMapping { RoRaBaChCo, RoRaBaCoCh, RoCoRaBaCh };
+
+    enum Field { Column, Channel, Bank, Rank, Row, NumFields };
+
+    Addr radix(Field f) const
+    {
+        switch (f) {
+          case Column: return columnsPerRowBuffer;
+          case Channel: return channels;
+          case Bank: return banksPerRank;
+          case Rank: return ranksPerChannel;
+          default: return 0;
+        }
+    }
+
+    /** Split an address to its DRAM fields, Row is not truncated */
+    void split(Addr addr, Addr *fields, Addr *byte_offset) const;
+    Addr join(const Addr *fields, Addr byte_offset) const;
+
+    const Addr base;
+    AddrMapping mapping;
+    bool closePage;
+
+    unsigned _burstSize;
+    unsigned _rowBufferSize;
+    unsigned columnsPerRowBuffer;
+    unsigned banksPerRank;
+    unsigned ranksPerChannel;
+    unsigned channels;
+    Addr rowsPerBank;
+
+    static const Addr NoRow = (Addr)-1;
+    std::vector<Addr> openRow;
+};
+
+#endif	// __MEM_PARD_DRAM_SHADOW_HH__
@@ -0,0 +1,69 @@
+#include <cassert>
+
+#include "mem/pard_dsid_arbiter.hh"
+
+DSidArbiter::DSidArbiter(unsigned default_weight)
+    : defaultWeight(default_weight ? default_weight : 1)
+{
+}
+
+void
+DSidArbiter::setWeight(uint16_t DSid, unsigned weight)
+{
+    if (weight)
+        weights[DSid] = weight;
+    else
+        weights.erase(DSid);
+}
+
+unsigned
+DSidArbiter::getWeight(uint16_t DSid) const
+{
+    auto it = weights.find(DSid);
+    return (it == weights.end()) ? defaultWeight : it->second;
+}
+
+void
+DSidArbiter::setDefaultWeight(unsigned weight)
+{
+    defaultWeight = weight ? weight : 1;
+}
+
+void
+DSidArbiter::enqueue(uint16_t DSid, PortID port)
+{
+    Flow &flow = flows[DSid];
+    if (flow.ports.empty())
+        active.push_back(DSid);
+    flow.ports.push_back(port);
+}
+
+PortID
+DSidArbiter::grant(uint16_t *DSid)
+{
+    assert(!active.empty());
+
+    // Head of the round replenishes its deficit when it is used up,
+    // weights are at least 1, so this never loops
+    uint16_t head = active.front();
+    Flow &flow = flows[head];
+    if (flow.deficit == 0)
+        flow.deficit = getWeight(head);
+
+    PortID port = flow.ports.front();
+    flow.ports.pop_front();
+    flow.deficit--;
+
+    active.pop_front();
+    if (flow.ports.empty()) {
+        // idle flows do not save their deficit
+        flows.erase(head);
+    } else if (flow.deficit) {
+        active.push_front(head);
+    } else {
+        active.push_back(head);
+    }
+
+    *DSid = head;
+    return port;
+}
@@ -0,0 +1,60 @@
+#ifndef __MEM_PARD_DSID_ARBITER_HH__
+#define __MEM_PARD_DSID_ARBITER_HH__
+
+#include <deque>
+#include <list>
+#include <unordered_map>
+
+#include "base/types.hh"
+
+/**
+ * Deficit round-robin arbiter among DSids.
+ *
+ * Ports holding a request are queued in the flow of the DSid of that
+ * request. Each backlogged DSid receives `weight' grants per round,
+ * so under contention the share of a DSid is proportional to its
+ * weight, regardless of how many requests it keeps issuing.
+ */
+class DSidArbiter
+{
+  public:
+
+    DSidArbiter(unsigned default_weight);
+
+    void setWeight(uint16_t DSid, unsigned weight);
+    unsigned getWeight(uint16_t DSid) const;
+
+    void setDefaultWeight(unsigned weight);
+    unsigned getDefaultWeight() const { return defaultWeight; }
+
+    /** Queue a port waiting with a request of DSid */
+    void enqueue(uint16_t DSid, PortID port);
+
+    bool empty() const { return active.empty(); }
+
+    /**
+     * Pick the next waiting port, the arbiter must not be empty.
+     *
+     * @param DSid returns DSid of the granted request
+     * @return the granted port
+     */
+    PortID grant(uint16_t *DSid);
+
+  private:
+
+    struct Flow {
+        std::deque<PortID> ports;
+        unsigned deficit;
+        Flow() : deficit(0) { }
+    };
+
+    unsigned defaultWeight;
+
+    std::unordered_map<uint16_t, unsigned> weights;
+    std::unordered_map<uint16_t, Flow> flows;
+
+    /** Backlogged DSids, in round-robin order */
+    std::list<uint16_t> active;
+};
+
+#endif	// __MEM_PARD_DSID_ARBITER_HH__
@@ -0,0 +1,32 @@
+#include "base/misc.hh"
+#include "mem/pard_dsid_classifier.hh"
+
+DSidClassifier::DSidClassifier(const std::string &name,
+                               uint16_t default_dsid,
+                               const std::vector<AddrRange> &ranges,
+                               const std::vector<unsigned> &dsids)
+    : defaultDSid(default_dsid), lastValid(false), lastDSid(0)
+{
+    fatal_if(ranges.size() != dsids.size(),
+             "%s: %d DSid ranges but %d DSids\n", name, ranges.size(),
+             dsids.size());
+
+    for (size_t i = 0; i < ranges.size(); i++) {
+        fatal_if(rangeMap.insert(ranges[i], dsids[i]) == rangeMap.end(),
+                 "%s: DSid range %s overlaps another range\n", name,
+                 ranges[i].to_string());
+    }
+}
+
+uint16_t
+DSidClassifier::lookup(Addr addr)
+{
+    auto i = rangeMap.find(addr);
+    if (i == rangeMap.end())
+        return defaultDSid;
+
+    lastValid = true;
+    lastRange = i->first;
+    lastDSid = i->second;
+    return lastDSid;
+}
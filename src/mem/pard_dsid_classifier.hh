@@ -0,0 +1,54 @@
+#ifndef __MEM_PARD_DSID_CLASSIFIER_HH__
+#define __MEM_PARD_DSID_CLASSIFIER_HH__
+
+#include <string>
+#include <vector>
+
+#include "base/addr_range.hh"
+#include "base/addr_range_map.hh"
+#include "base/types.hh"
+
+/**
+ * Classify requests to DSids by address.
+ *
+ * Ranges are kept in an AddrRangeMap, addresses outside all ranges
+ * get the default DSid. The range of the last hit is remembered, as
+ * requests of a tenant mostly stay within the same range.
+ */
+class DSidClassifier
+{
+  public:
+
+    /**
+     * @param name owner name, for error messages
+     * @param ranges address ranges to classify
+     * @param dsids DSid of each range
+     */
+    DSidClassifier(const std::string &name, uint16_t default_dsid,
+                   const std::vector<AddrRange> &ranges,
+                   const std::vector<unsigned> &dsids);
+
+    uint16_t classify(Addr addr)
+    {
+        if (lastValid && lastRange.contains(addr))
+            return lastDSid;
+        if (rangeMap.empty())
+            return defaultDSid;
+        return lookup(addr);
+    }
+
+    uint16_t getDefaultDSid() const { return defaultDSid; }
+
+  private:
+
+    uint16_t lookup(Addr addr);
+
+    uint16_t defaultDSid;
+    AddrRangeMap<uint16_t> rangeMap;
+
+    bool lastValid;
+    AddrRange lastRange;
+    uint16_t lastDSid;
+};
+
+#endif	// __MEM_PARD_DSID_CLASSIFIER_HH__
@@ -0,0 +1,195 @@
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+
+#include "base/misc.hh"
+#include "debug/PARDMemoryCtrl.hh"
+#include "mem/pard_mem_backing.hh"
+
+LDomBackingStore::LDomBackingStore(const std::string &name,
+                                   Enums::PARDMemBacking _type,
+                                   const std::string &_dir)
+    : _name(name), type(_type), dir(_dir)
+{
+    fatal_if(type == Enums::pard_backing_file && dir.empty(),
+             "%s: file backing requires backing_dir\n", name);
+#ifndef MAP_HUGETLB
+    fatal_if(type == Enums::pard_backing_hugepage,
+             "%s: huge page backing is not supported on this host\n", name);
+#endif
+}
+
+LDomBackingStore::~LDomBackingStore()
+{
+    for (auto &s : stores) {
+        if (s.second.fd >= 0)
+            close(s.second.fd);
+    }
+}
+
+size_t
+LDomBackingStore::alignment() const
+{
+    if (type == Enums::pard_backing_hugepage)
+        return 2 * 1024 * 1024;
+    return sysconf(_SC_PAGESIZE);
+}
+
+std::string
+LDomBackingStore::fileName(uint16_t DSid) const
+{
+    return csprintf("%s/%s.ldom%d", dir, name(), DSid);
+}
+
+bool
+LDomBackingStore::attach(uint16_t DSid, const std::vector<Region> &regions)
+{
+    if (!enabled())
+        return false;
+
+    // already there, keep the memory of the LDom
+    auto it = stores.find(DSid);
+    if (it != stores.end() && sameRegions(it->second.regions, regions))
+        return true;
+
+    // the file of a moving LDom is taken along, never truncated
+    int fd = -1;
+    if (it != stores.end()) {
+        fd = it->second.fd;
+        it->second.fd = -1;
+    }
+    detach(DSid);
+
+    size_t total = 0;
+    for (auto &r : regions) {
+        if ((uintptr_t)r.host % alignment() || r.size % alignment()) {
+            warn("%s: DSid#%d region %p+0x%x not aligned to 0x%x, keep "
+                 "shared backing\n", name(), DSid, r.host, r.size,
+                 alignment());
+            if (fd >= 0)
+                close(fd);
+            return false;
+        }
+        total += r.size;
+    }
+
+    Store store;
+    store.fd = fd;
+
+    if (type == Enums::pard_backing_file) {
+        std::string file = fileName(DSid);
+        if (store.fd < 0)
+            store.fd = open(file.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+        if (store.fd < 0 || ftruncate(store.fd, total) < 0) {
+            warn("%s: cannot create backing file %s: %s\n", name(), file,
+                 strerror(errno));
+            if (store.fd >= 0)
+                close(store.fd);
+            return false;
+        }
+    }
+
+    off_t file_offset = 0;
+    for (auto &r : regions) {
+        void *p;
+        if (type == Enums::pard_backing_file) {
+            p = mmap(r.host, r.size, PROT_READ | PROT_WRITE,
+                     MAP_SHARED | MAP_FIXED, store.fd, file_offset);
+            file_offset += r.size;
+        } else {
+            int flags = MAP_PRIVATE | MAP_ANON | MAP_NORESERVE | MAP_FIXED;
+            p = MAP_FAILED;
+#ifdef MAP_HUGETLB
+            // no huge pages reserved on the host is fine, only slower
+            if (type == Enums::pard_backing_hugepage) {
+                p = mmap(r.host, r.size, PROT_READ | PROT_WRITE,
+                         flags | MAP_HUGETLB, -1, 0);
+                if (p == MAP_FAILED)
+                    warn("%s: no huge pages for DSid#%d at %p+0x%x (%s), "
+                         "use normal pages\n", name(), DSid, r.host,
+                         r.size, strerror(errno));
+            }
+#endif
+            if (p == MAP_FAILED)
+                p = mmap(r.host, r.size, PROT_READ | PROT_WRITE, flags,
+                         -1, 0);
+        }
+
+        // the old mapping of the region is gone at this point
+        panic_if(p == MAP_FAILED, "%s: cannot map DSid#%d backing at "
+                 "%p+0x%x: %s\n", name(), DSid, r.host, r.size,
+                 strerror(errno));
+    }
+
+    DPRINTF(PARDMemoryCtrl, "DSid#%d: own backing, %d regions, %d bytes\n",
+            DSid, regions.size(), total);
+
+    store.regions = regions;
+    stores[DSid] = store;
+    return true;
+}
+
+bool
+LDomBackingStore::sameRegions(const std::vector<Region> &a,
+                              const std::vector<Region> &b)
+{
+    if (a.size() != b.size())
+        return false;
+    for (size_t i = 0; i < a.size(); i++) {
+        if (a[i].host != b[i].host || a[i].size != b[i].size)
+            return false;
+    }
+    return true;
+}
+
+void
+LDomBackingStore::detach(uint16_t DSid)
+{
+    auto it = stores.find(DSid);
+    if (it == stores.end())
+        return;
+
+    for (auto &r : it->second.regions) {
+        void *p = mmap(r.host, r.size, PROT_READ | PROT_WRITE,
+                       MAP_PRIVATE | MAP_ANON | MAP_NORESERVE | MAP_FIXED,
+                       -1, 0);
+        panic_if(p == MAP_FAILED, "%s: cannot unmap DSid#%d backing at "
+                 "%p+0x%x: %s\n", name(), DSid, r.host, r.size,
+                 strerror(errno));
+    }
+    if (it->second.fd >= 0)
+        close(it->second.fd);
+
+    DPRINTF(PARDMemoryCtrl, "DSid#%d: back to shared backing\n", DSid);
+    stores.erase(it);
+}
+
+void
+LDomBackingStore::drop(const std::vector<Region> &regions)
+{
+    for (auto &r : regions) {
+        if (madvise(r.host, r.size, MADV_DONTNEED) < 0)
+            warn("%s: cannot drop %p+0x%x: %s\n", name(), r.host, r.size,
+                 strerror(errno));
+    }
+}
+
+void
+LDomBackingStore::sync(uint16_t DSid)
+{
+    auto it = stores.find(DSid);
+    if (it == stores.end() || it->second.fd < 0) {
+        warn("%s: DSid#%d is not file backed, nothing to sync\n",
+             name(), DSid);
+        return;
+    }
+
+    for (auto &r : it->second.regions) {
+        if (msync(r.host, r.size, MS_SYNC) < 0)
+            warn("%s: cannot sync DSid#%d: %s\n", name(), DSid,
+                 strerror(errno));
+    }
+}
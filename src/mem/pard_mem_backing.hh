@@ -0,0 +1,84 @@
+#ifndef __MEM_PARD_MEM_BACKING_HH__
+#define __MEM_PARD_MEM_BACKING_HH__
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "base/types.hh"
+#include "enums/PARDMemBacking.hh"
+
+/**
+ * Per-LDom host backing stores of PARDMemoryCtrl.
+ *
+ * All internal memories share the flat backing store created by
+ * PhysicalMemory. An LDom attached here gets its own mapping placed
+ * (MAP_FIXED) over the host regions of its memory segment, either an
+ * anonymous region, an anonymous huge page region, or a file in
+ * backing_dir, so its memory can be dropped, synced to disk or
+ * snapshotted without touching other LDoms.
+ */
+class LDomBackingStore
+{
+  public:
+
+    /** Host region of an LDom, page aligned */
+    struct Region {
+        uint8_t *host;
+        size_t size;
+    };
+
+    LDomBackingStore(const std::string &name, Enums::PARDMemBacking _type,
+                     const std::string &_dir);
+    ~LDomBackingStore();
+
+    /** Whether LDoms get their own backing at all */
+    bool enabled() const { return type != Enums::pard_backing_shared; }
+
+    /** Required alignment of regions */
+    size_t alignment() const;
+
+    /**
+     * Map a backing of DSid over regions. Nothing changes if DSid is
+     * attached to the same regions already. Otherwise, its former
+     * regions go back to anonymous memory, and the contents of regions
+     * are lost, except that a file backing keeps its file and so its
+     * contents. Return false if nothing is mapped.
+     */
+    bool attach(uint16_t DSid, const std::vector<Region> &regions);
+
+    /** Put regions of DSid back to anonymous memory */
+    void detach(uint16_t DSid);
+
+    bool attached(uint16_t DSid) const { return stores.count(DSid); }
+
+    /**
+     * Release host pages of regions. Anonymous memory reads as zero
+     * afterwards, file backed memory is read back from the file.
+     */
+    void drop(const std::vector<Region> &regions);
+
+    /** Write file backed memory of DSid to its file */
+    void sync(uint16_t DSid);
+
+  private:
+
+    struct Store {
+        std::vector<Region> regions;
+        int fd;
+    };
+
+    const std::string _name;
+    const Enums::PARDMemBacking type;
+    const std::string dir;
+
+    std::map<uint16_t, Store> stores;
+
+    const std::string &name() const { return _name; }
+    std::string fileName(uint16_t DSid) const;
+
+    static bool sameRegions(const std::vector<Region> &a,
+                            const std::vector<Region> &b);
+};
+
+#endif	// __MEM_PARD_MEM_BACKING_HH__
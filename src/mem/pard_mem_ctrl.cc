@@ -1,13 +1,89 @@
+#include <algorithm>
+#include <cstring>
+
+#include "base/intmath.hh"
+#include "debug/Drain.hh"
 #include "debug/PARDMemoryCtrl.hh"
 #include "mem/pard_mem_ctrl.hh"
+#include "sim/system.hh"
 
 PARDMemoryCtrl::PARDMemoryCtrl(const PARDMemoryCtrlParams* p)
     : MemObject(p),
       port(name() + ".port", *this),
-      internal_port(name() + ".internal_port", *this)
-      //memories(p->memories)
+      internal_port(name() + ".internal_port", *this),
+      memories(p->memories),
+      cp(p->cp),
+      channelIntlvSize(p->channel_intlv_size),
+      nextSeqNum(0),
+      readQueueSize(p->read_queue_size),
+      writeQueueSize(p->write_queue_size),
+      writeHighThreshold(writeQueueSize * p->write_high_thresh_perc / 100.0),
+      writeLowThreshold(writeQueueSize * p->write_low_thresh_perc / 100.0),
+      schedPolicy(p->sched_policy),
+      starvationLimit(p->starvation_limit),
+      maxOutstanding(p->max_outstanding),
+      outstanding(0), drainingWrites(false), retryReq(false),
+      retryHeld(false), retryDSid(0),
+      waitingForRetry(false), drainManager(NULL),
+      sendEvent(this),
+      buckets(p->remap_table_entries),
+      throttleQueueSize(p->throttle_queue_size),
+      refillEvent(this),
+      remapTable(p->remap_table_entries),
+      bankColors(p->remap_table_entries),
+      channelPolicy(p->remap_table_entries, ChannelInterleave),
+      system(p->system),
+      backing(name(), p->ldom_backing, p->backing_dir),
+      backingReady(false)
 {
-      memories.push_back(p->memories);
+    panic_if(maxOutstanding == 0, "%s: max_outstanding must be non-zero\n",
+             name());
+
+    // Channels are contiguous and of the same size, in order
+    panic_if(memories.empty(), "%s: no internal memories\n", name());
+    memBase = memories[0]->getAddrRange().start();
+    channelSize = memories[0]->size();
+    shadows.reserve(memories.size());
+    for (unsigned i = 0; i < memories.size(); i++) {
+        const AddrRange &range = memories[i]->getAddrRange();
+        panic_if(range.interleaved() ||
+                 range.start() != memBase + i * channelSize ||
+                 range.size() != channelSize,
+                 "%s: channel %s should be [0x%x, 0x%x) and not "
+                 "interleaved\n", name(), memories[i]->name(),
+                 memBase + i * channelSize, memBase + (i+1) * channelSize);
+        shadows.push_back(DRAMRowShadow(memories[i]));
+    }
+    panic_if(channelIntlvSize < shadows[0].burstSize() ||
+             !isPowerOf2(channelIntlvSize) ||
+             channelSize % channelIntlvSize,
+             "%s: bad channel interleaving size %d\n", name(),
+             channelIntlvSize);
+
+    for (auto &entry : remapTable)
+        entry.valid = false;
+
+    for (auto &bucket : buckets) {
+        bucket.rate = 0;
+        bucket.burst = 0;
+        bucket.tokens = 0;
+        bucket.lastRefill = 0;
+    }
+
+    // default layout: DSid#i ==> [i*size, (i+1)*size)
+    panic_if(p->default_ldoms > remapTable.size(),
+             "%s: default_ldoms (%d) exceeds remap table size (%d)\n",
+             name(), p->default_ldoms, remapTable.size());
+    for (unsigned i = 0; i < p->default_ldoms; i++) {
+        Layout layout = { 0, p->default_ldom_size,
+                          i * p->default_ldom_size, ChannelInterleave, 0 };
+        if (!setLayout(i, layout))
+            fatal("%s: default LDom %d does not fit in memory\n",
+                  name(), i);
+    }
+
+    cp->regPARDMemoryCtrl(this);
+    cp->registerCommandHandler(static_cast<ICommandHandler *>(this));
 }
 
 void
@@ -24,6 +100,40 @@ PARDMemoryCtrl::init()
     } else {
         port.sendRangeChange();
     }
+
+    // host backing stores exist now, give LDoms their own
+    backingReady = true;
+    for (unsigned i = 0; i < remapTable.size(); i++) {
+        if (remapTable[i].valid)
+            rebindBacking(i);
+    }
+}
+
+unsigned int
+PARDMemoryCtrl::drain(DrainManager *dm)
+{
+    if (readQueue.empty() && writeQueue.empty() && throttledDSids.empty()) {
+        setDrainState(Drainable::Drained);
+        return 0;
+    }
+
+    DPRINTF(Drain, "%s: %d reads, %d writes and %d throttled LDoms not "
+            "yet sent\n", name(), readQueue.size(), writeQueue.size(),
+            throttledDSids.size());
+    drainManager = dm;
+    setDrainState(Drainable::Draining);
+    return 1;
+}
+
+void
+PARDMemoryCtrl::checkDrained()
+{
+    if (drainManager && readQueue.empty() && writeQueue.empty() &&
+        throttledDSids.empty()) {
+        setDrainState(Drainable::Drained);
+        drainManager->signalDrainDone();
+        drainManager = NULL;
+    }
 }
 
 AddrRangeList
@@ -35,69 +145,882 @@ PARDMemoryCtrl::getAddrRanges() const
     return ranges;
 }
 
+uint64_t
+PARDMemoryCtrl::getMemorySize() const
+{
+    uint64_t size = 0;
+    for (auto mem : memories)
+        size += mem->size();
+    return size;
+}
+
+bool
+PARDMemoryCtrl::setLayout(uint16_t DSid, const Layout &layout)
+{
+    if (DSid >= remapTable.size()) {
+        warn("%s: DSid 0x%x out of remap table\n", name(), DSid);
+        return false;
+    }
+
+    // a zero sized layout keeps the segment in effect
+    RemapEntry remap = remapTable[DSid];
+    if (layout.size) {
+        remap.base   = layout.base;
+        remap.size   = layout.size;
+        remap.offset = layout.offset;
+        remap.valid  = true;
+    }
+
+    DRAMRowShadow::BankColor color;
+    if (!makeColor(DSid, layout.bankMask, remap, layout.channel, color) ||
+        !checkLayout(DSid, remap.valid ? remap.offset : 0,
+                     remap.valid ? remap.span : 0, layout.channel))
+        return false;
+
+    if (remap.valid)
+        DPRINTF(PARDMemoryCtrl, "remap DSid#%d: [0x%x, 0x%x) ==> 0x%x\n",
+                DSid, remap.base, remap.base + remap.size, remap.offset);
+    DPRINTF(PARDMemoryCtrl, "DSid#%d: %s %d, %d banks\n", DSid,
+            layout.channel == ChannelInterleave ?
+            "interleaved over" : "pinned to",
+            layout.channel == ChannelInterleave ?
+            memories.size() : layout.channel,
+            color.banks.empty() ? shadows[0].numBanks() :
+            color.banks.size());
+
+    remapTable[DSid] = remap;
+    channelPolicy[DSid] = layout.channel;
+    bankColors[DSid] = color;
+    rebindBacking(DSid);
+    return true;
+}
+
+void
+PARDMemoryCtrl::clearLayout(uint16_t DSid, bool remap)
+{
+    if (DSid >= remapTable.size())
+        return;
+
+    DPRINTF(PARDMemoryCtrl, "DSid#%d: layout cleared%s\n", DSid,
+            remap ? "" : ", segment kept");
+    if (remap)
+        remapTable[DSid].valid = false;
+    remapTable[DSid].span = remapTable[DSid].size;
+    channelPolicy[DSid] = ChannelInterleave;
+    bankColors[DSid].banks.clear();
+    rebindBacking(DSid);
+}
+
+bool
+PARDMemoryCtrl::makeColor(uint16_t DSid, uint64_t mask,
+                          RemapEntry &remap, int channel,
+                          DRAMRowShadow::BankColor &color) const
+{
+    remap.span = remap.size;
+    color.banks.clear();
+    unsigned banks = shadows[0].numBanks();
+    for (unsigned i = 0; i < banks && i < 64; i++) {
+        if (mask & (ULL(1) << i))
+            color.banks.push_back(i);
+    }
+
+    // all banks (or none) allowed, no coloring at all
+    if (color.banks.size() == banks || color.banks.empty()) {
+        color.banks.clear();
+        return true;
+    }
+
+    if (!isPowerOf2(color.banks.size())) {
+        unsigned ways = 1 << floorLog2(color.banks.size());
+        warn("%s: DSid#%d bank mask 0x%x has %d banks, only the first %d "
+             "are used\n", name(), DSid, mask, color.banks.size(), ways);
+        color.banks.resize(ways);
+    }
+
+    // the LDom must own whole rows of every bank of its channels,
+    // banks/ways times the rows it addresses
+    Addr stride = shadows[0].rowStride();
+    Addr spread = banks / color.banks.size();
+    Addr local, size;
+    if (!remap.valid || !remap.size ||
+        !channelWindow(remap.offset, remap.size * spread, channel,
+                       &local, &size) ||
+        local % stride || size % (stride * spread)) {
+        warn("%s: DSid#%d memory is not whole DRAM rows, bank mask 0x%x "
+             "rejected\n", name(), DSid, mask);
+        return false;
+    }
+
+    remap.span = remap.size * spread;
+    color.firstRow = local / stride;
+    color.numRows = size / stride;
+    return true;
+}
+
+bool
+PARDMemoryCtrl::footprint(Addr offset, Addr size, int channel,
+                          Addr *lo, Addr *hi) const
+{
+    Addr num_channels = memories.size();
+    if (channel == ChannelInterleave) {
+        // stripes touched by the segment, on every channel
+        Addr stripe = channelIntlvSize * num_channels;
+        *lo = (offset / stripe) * channelIntlvSize;
+        *hi = divCeil(offset + size, stripe) * channelIntlvSize;
+        return offset + size <= num_channels * channelSize;
+    } else {
+        *lo = offset % channelSize;
+        *hi = *lo + size;
+        return *hi <= channelSize;
+    }
+}
+
+bool
+PARDMemoryCtrl::checkLayout(uint16_t DSid, Addr offset, Addr size,
+                            int channel) const
+{
+    if (channel != ChannelInterleave &&
+        (channel < 0 || channel >= (int)memories.size())) {
+        warn("%s: DSid#%d pinned to unknown channel %d\n",
+             name(), DSid, channel);
+        return false;
+    }
+
+    Addr lo, hi;
+    if (!footprint(offset, size, channel, &lo, &hi)) {
+        warn("%s: DSid#%d segment [0x%x, 0x%x) does not fit in %s\n",
+             name(), DSid, offset, offset + size,
+             channel == ChannelInterleave ? "memory" : "its channel");
+        return false;
+    }
+
+    // segments must not overlap segments sharing their channels
+    for (unsigned i = 0; size && i < remapTable.size(); i++) {
+        const RemapEntry &other = remapTable[i];
+        int other_channel = channelPolicy[i];
+        if (i == DSid || !other.valid || !other.span)
+            continue;
+        if (channel != ChannelInterleave &&
+            other_channel != ChannelInterleave && channel != other_channel)
+            continue;
+
+        // interleaved segments share the same mapping, compare them
+        // exactly, otherwise by the stripes they may touch
+        Addr other_lo, other_hi;
+        bool overlap;
+        if (channel == ChannelInterleave &&
+            other_channel == ChannelInterleave) {
+            overlap = offset < other.offset + other.span &&
+                      other.offset < offset + size;
+        } else {
+            footprint(other.offset, other.span, other_channel,
+                      &other_lo, &other_hi);
+            overlap = lo < other_hi && other_lo < hi;
+        }
+        if (overlap) {
+            warn("%s: DSid#%d segment [0x%x, 0x%x) overlaps DSid#%d\n",
+                 name(), DSid, offset, offset + size, i);
+            return false;
+        }
+    }
+    return true;
+}
+
+bool
+PARDMemoryCtrl::channelWindow(Addr offset, Addr size, int channel,
+                              Addr *local, Addr *local_size) const
+{
+    Addr num_channels = memories.size();
+    if (channel == ChannelInterleave) {
+        Addr stripe = channelIntlvSize * num_channels;
+        if (offset % stripe || size % stripe)
+            return false;
+        *local = offset / num_channels;
+        *local_size = size / num_channels;
+    } else {
+        *local = offset % channelSize;
+        *local_size = size;
+    }
+    return *local + *local_size <= channelSize;
+}
+
+bool
+PARDMemoryCtrl::ldomRegions(uint16_t DSid,
+                            std::vector<LDomBackingStore::Region> &regions)
+    const
+{
+    const RemapEntry *entry = getRemapEntry(DSid);
+    if (!entry || !entry->size || !bankColors[DSid].banks.empty())
+        return false;
+
+    // internal ranges of the segment, one per channel it occupies
+    std::vector<std::pair<Addr, Addr> > ranges;
+    Addr local, size;
+    if (!channelWindow(entry->offset, entry->size, channelPolicy[DSid],
+                       &local, &size))
+        return false;
+    if (channelPolicy[DSid] == ChannelInterleave) {
+        for (Addr c = 0; c < memories.size(); c++)
+            ranges.push_back(std::make_pair(
+                memBase + c * channelSize + local, size));
+    } else {
+        ranges.push_back(std::make_pair(
+            memBase + channelPolicy[DSid] * channelSize + local, size));
+    }
+
+    // internal ranges to host
+    regions.clear();
+    const auto &stores = system->getPhysMem().getBackingStore();
+    for (auto &range : ranges) {
+        bool found = false;
+        for (auto &store : stores) {
+            if (store.first.contains(range.first) &&
+                store.first.contains(range.first + range.second - 1)) {
+                LDomBackingStore::Region r;
+                r.host = store.second + (range.first - store.first.start());
+                r.size = range.second;
+                regions.push_back(r);
+                found = true;
+                break;
+            }
+        }
+        if (!found)
+            return false;
+    }
+    return true;
+}
+
+void
+PARDMemoryCtrl::rebindBacking(uint16_t DSid)
+{
+    if (!backingReady || !backing.enabled())
+        return;
+
+    std::vector<LDomBackingStore::Region> regions;
+    if (getRemapEntry(DSid) && ldomRegions(DSid, regions)) {
+        if (backing.attach(DSid, regions))
+            return;
+    } else if (getRemapEntry(DSid)) {
+        warn("%s: DSid#%d memory is scattered, keep shared backing\n",
+             name(), DSid);
+    }
+    backing.detach(DSid);
+}
+
+void
+PARDMemoryCtrl::dropLDomMemory(uint16_t DSid)
+{
+    std::vector<LDomBackingStore::Region> regions;
+    if (!ldomRegions(DSid, regions)) {
+        warn("%s: cannot drop memory of DSid#%d\n", name(), DSid);
+        return;
+    }
+
+    DPRINTF(PARDMemoryCtrl, "DSid#%d: drop memory\n", DSid);
+    backing.drop(regions);
+}
+
+void
+PARDMemoryCtrl::syncLDomMemory(uint16_t DSid)
+{
+    DPRINTF(PARDMemoryCtrl, "DSid#%d: sync memory\n", DSid);
+    backing.sync(DSid);
+}
+
+bool
+PARDMemoryCtrl::handleCommand(int cmd, uint64_t arg1, uint64_t arg2,
+                              uint64_t arg3)
+{
+    uint16_t DSid = (uint16_t)arg1;
+
+    DPRINTF(PARDMemoryCtrl, "handleCommand(cmd=%d, DSid=%d)\n", cmd, DSid);
+
+    if (cmd == 'D') {           // drop ldom memory
+        dropLDomMemory(DSid);
+    } else if (cmd == 'Y') {    // sync ldom memory to backing file
+        syncLDomMemory(DSid);
+    } else {
+        return false;
+    }
+
+    return true;
+}
+
 Addr
 PARDMemoryCtrl::remapAddr(uint16_t DSid, Addr addr) const
 {
-    if (DSid < 4) {
-        DPRINTF(PARDMemoryCtrl, "[%d] 0x%016x ==> 0x%016x\n", DSid, addr, addr + (uint64_t)DSid*0x80000000);
-        return addr + (uint64_t)DSid*0x80000000;
-    }
-    else {
+    if (DSid >= remapTable.size() || !remapTable[DSid].valid)
         panic("PARDMemoryCtrl::remapAddr(): unknown DSid 0x%x\n", DSid);
-        return addr;
+
+    const RemapEntry &entry = remapTable[DSid];
+    if (addr < entry.base || addr - entry.base >= entry.size)
+        panic("PARDMemoryCtrl::remapAddr(): DSid#%d access 0x%x out of "
+              "[0x%x, 0x%x)\n", DSid, addr, entry.base,
+              entry.base + entry.size);
+
+    // DSid-relative to internal address, then to a channel
+    Addr internal = addr - entry.base + entry.offset;
+    Addr num_channels = memories.size();
+    Addr channel, local;
+    if (channelPolicy[DSid] == ChannelInterleave) {
+        panic_if(internal >= num_channels * channelSize,
+                 "PARDMemoryCtrl::remapAddr(): DSid#%d 0x%x beyond "
+                 "internal memories\n", DSid, internal);
+        channel = (internal / channelIntlvSize) % num_channels;
+        local = (internal / (channelIntlvSize * num_channels))
+                * channelIntlvSize + internal % channelIntlvSize;
+    } else {
+        channel = channelPolicy[DSid];
+        local = internal % channelSize;
+    }
+
+    Addr remapped = memBase + channel * channelSize + local;
+    if (!bankColors[DSid].banks.empty())
+        remapped = shadows[channel].colorAddr(remapped, bankColors[DSid]);
+    DPRINTF(PARDMemoryCtrl, "[%d] 0x%016x ==> 0x%016x\n",
+            DSid, addr, remapped);
+    return remapped;
+}
+
+unsigned
+PARDMemoryCtrl::accessRowShadow(Addr addr, unsigned size, unsigned *bursts)
+{
+    DRAMRowShadow &shadow = shadowOf(addr);
+    unsigned burst_size = shadow.burstSize();
+    unsigned hits = 0;
+
+    *bursts = shadow.numBursts(addr, size);
+    Addr burst_addr = addr - (addr % burst_size);
+    for (unsigned i = 0; i < *bursts; i++, burst_addr += burst_size) {
+        if (shadow.access(burst_addr))
+            hits++;
     }
+    return hits;
 }
 
 Tick
 PARDMemoryCtrl::recvAtomic(PacketPtr pkt)
 {
+    uint16_t DSid = pkt->getDSid();
     Addr orig_addr = pkt->getAddr();
-    pkt->setAddr(remapAddr(pkt->getDSid(), orig_addr));
+    pkt->setAddr(remapAddr(DSid, orig_addr));
     pkt->firstWordDelay = pkt->lastWordDelay = 0;
+
+    if (pkt->isRead() || pkt->isWrite()) {
+        unsigned bursts;
+        unsigned row_hits = accessRowShadow(pkt->getAddr(), pkt->getSize(),
+                                            &bursts);
+        cp->recordRequest(DSid, pkt->isRead(), pkt->getSize(),
+                          bursts, row_hits);
+        cp->recordResponse(DSid, pkt->isRead(), 0, 0, 0);
+    }
+
     Tick ret_tick = internal_port.sendAtomic(pkt);
     pkt->setAddr(orig_addr);
     return ret_tick;
 }
 
-bool
-PARDMemoryCtrl::recvTimingReq(PacketPtr pkt)
+PARDMemoryCtrl::SchedEntry
+PARDMemoryCtrl::makeSchedEntry(PacketPtr pkt)
 {
-    Addr orig_addr = pkt->getAddr();
-    bool needsResponse = pkt->needsResponse();
-    bool memInhibitAsserted = pkt->memInhibitAsserted();
+    SchedEntry entry;
+    entry.pkt = pkt;
+    entry.DSid = pkt->getDSid();
+    entry.entryTick = curTick();
+    entry.seqNum = nextSeqNum++;
 
-    if (!memInhibitAsserted && needsResponse)
-        pkt->pushSenderState(new RequestState(pkt->getSrc(), orig_addr));
+    const MemCtrlParamEntry *param = cp->getParamEntry(entry.DSid);
+    entry.priority = param ? param->effective_priority : 0;
+
+    if (!pkt->memInhibitAsserted() && pkt->needsResponse())
+        pkt->pushSenderState(new RequestState(this, pkt->getSrc(),
+                                              pkt->getAddr()));
     pkt->firstWordDelay = pkt->lastWordDelay = 0;
 
-    pkt->setAddr(remapAddr(pkt->getDSid(), orig_addr));
+    entry.addr = remapAddr(entry.DSid, pkt->getAddr());
+    pkt->setAddr(entry.addr);
+
+    return entry;
+}
+
+bool
+PARDMemoryCtrl::sendToDRAM(const SchedEntry &entry)
+{
+    PacketPtr pkt = entry.pkt;
+    unsigned size = pkt->getSize();
+    bool isRead = pkt->isRead();
+    bool accounted = !pkt->memInhibitAsserted() && (isRead || pkt->isWrite());
+    RequestState *req_state = NULL;
+
+    if (!pkt->memInhibitAsserted() && pkt->needsResponse()) {
+        req_state = RequestState::peek(pkt, this);
+        assert(req_state);
+    }
 
     // Attempt to send the packet (always succeeds for inhibited
-    // packets)
-    bool successful = internal_port.sendTimingReq(pkt);
+    // packets), note that pkt may already be freed by the DRAM
+    // controller if it needs no response
+    if (!internal_port.sendTimingReq(pkt))
+        return false;
 
-    // If not successful, restore the sender state
-    if (!successful && needsResponse)
-        delete pkt->popSenderState();
+    if (req_state)
+        outstanding++;
 
-    return successful;
+    if (accounted) {
+        unsigned bursts;
+        unsigned row_hits = accessRowShadow(entry.addr, size, &bursts);
+        cp->recordRequest(entry.DSid, isRead, size, bursts, row_hits);
+        if (req_state) {
+            req_state->bursts = bursts;
+            req_state->rowHits = row_hits;
+        } else {
+            // posted writes never come back, retire them now
+            cp->recordResponse(entry.DSid, isRead, 0, 0, 0);
+        }
+    }
+
+    return true;
+}
+
+bool
+PARDMemoryCtrl::recvTimingReq(PacketPtr pkt)
+{
+    uint16_t DSid = pkt->getDSid();
+    TokenBucket *bucket =
+        pkt->memInhibitAsserted() ? NULL : getBucket(DSid);
+    if (bucket)
+        refillBucket(*bucket);
+
+    // Hold requests of a DSid in debt, and behind its held requests
+    // even if its limit is gone meanwhile, keep its requests in order
+    TokenBucket *holder = NULL;
+    if (!pkt->memInhibitAsserted() && DSid < buckets.size() &&
+        (!buckets[DSid].pending.empty() || (bucket && bucket->tokens < 0)))
+        holder = &buckets[DSid];
+
+    if (holder) {
+        if (holder->pending.size() >= throttleQueueSize) {
+            DPRINTF(PARDMemoryCtrl, "DSid#%d throttled, 0x%x rejected\n",
+                    DSid, pkt->getAddr());
+            cp->recordRetry(DSid, pkt->isRead());
+            retryReq = true;
+            retryHeld = true;
+            retryDSid = DSid;
+            return false;
+        }
+
+        if (holder->pending.empty())
+            throttledDSids.push_back(DSid);
+        holder->pending.push_back(makeSchedEntry(pkt));
+        cp->recordThrottle(DSid);
+        scheduleRefill(curTick());
+        return true;
+    }
+
+    // Inhibited packets, and everything in pard_fcfs mode while the
+    // scheduler is idle, are passed through to DRAM controller
+    // directly.
+    bool idle = readQueue.empty() && writeQueue.empty() &&
+                !waitingForRetry && outstanding < maxOutstanding;
+    if (pkt->memInhibitAsserted() ||
+        (schedPolicy == Enums::pard_fcfs && idle)) {
+        Addr orig_addr = pkt->getAddr();
+        unsigned size = pkt->getSize();
+        SchedEntry entry = makeSchedEntry(pkt);
+        if (sendToDRAM(entry)) {
+            if (bucket)
+                bucket->tokens -= size;
+            return true;
+        }
+
+        // If not successful, restore the sender state and wait for
+        // the retry of DRAM controller
+        if (pkt->needsResponse())
+            delete pkt->popSenderState();
+        pkt->setAddr(orig_addr);
+        cp->recordRetry(entry.DSid, pkt->isRead());
+        waitingForRetry = true;
+        retryReq = true;
+        retryHeld = false;
+        return false;
+    }
+
+    std::deque<SchedEntry> &queue = pkt->isRead() ? readQueue : writeQueue;
+    unsigned queue_size = pkt->isRead() ? readQueueSize : writeQueueSize;
+    if (queue.size() >= queue_size) {
+        DPRINTF(PARDMemoryCtrl, "%s queue full, DSid#%d 0x%x rejected\n",
+                pkt->isRead() ? "read" : "write", pkt->getDSid(),
+                pkt->getAddr());
+        cp->recordRetry(pkt->getDSid(), pkt->isRead());
+        retryReq = true;
+        retryHeld = false;
+        return false;
+    }
+
+    if (bucket)
+        bucket->tokens -= pkt->getSize();
+    queue.push_back(makeSchedEntry(pkt));
+
+    // Defer scheduling to the end of this tick, so that requests
+    // arriving in the same tick compete with each other
+    if (!sendEvent.scheduled())
+        schedule(sendEvent, curTick());
+
+    return true;
+}
+
+void
+PARDMemoryCtrl::recvReqRetry()
+{
+    assert(waitingForRetry);
+    waitingForRetry = false;
+    trySchedule();
+
+    // Retry upstream in pass-through mode
+    if (retryReq && canRetry() && readQueue.empty() && writeQueue.empty()) {
+        retryReq = false;
+        port.sendRetry();
+    }
+}
+
+void
+PARDMemoryCtrl::processSendEvent()
+{
+    trySchedule();
+}
+
+std::deque<PARDMemoryCtrl::SchedEntry> *
+PARDMemoryCtrl::chooseQueue()
+{
+    if (readQueue.empty() && writeQueue.empty())
+        return NULL;
+    if (readQueue.empty())
+        return &writeQueue;
+    if (writeQueue.empty())
+        return &readQueue;
+
+    // pard_fcfs: strictly in arrival order
+    if (schedPolicy == Enums::pard_fcfs)
+        return writeQueue.front().entryTick < readQueue.front().entryTick ?
+               &writeQueue : &readQueue;
+
+    // Drain writes between the high and low watermark, otherwise
+    // favor reads unless the oldest write is starving
+    if (writeQueue.size() >= writeHighThreshold)
+        drainingWrites = true;
+    else if (writeQueue.size() <= writeLowThreshold)
+        drainingWrites = false;
+
+    if (drainingWrites)
+        return &writeQueue;
+
+    Tick write_age = curTick() - writeQueue.front().entryTick;
+    if (write_age >= starvationLimit &&
+        writeQueue.front().entryTick < readQueue.front().entryTick)
+        return &writeQueue;
+
+    return &readQueue;
+}
+
+bool
+PARDMemoryCtrl::hasHazard(const SchedEntry &entry) const
+{
+    Addr start = entry.addr;
+    Addr end = entry.addr + entry.pkt->getSize();
+
+    // reads may pass older reads only
+    for (auto &other : writeQueue) {
+        if (other.seqNum < entry.seqNum && other.addr < end &&
+            start < other.addr + other.pkt->getSize())
+            return true;
+    }
+    if (!entry.pkt->isRead()) {
+        for (auto &other : readQueue) {
+            if (other.seqNum < entry.seqNum && other.addr < end &&
+                start < other.addr + other.pkt->getSize())
+                return true;
+        }
+    }
+    return false;
+}
+
+std::deque<PARDMemoryCtrl::SchedEntry>::iterator
+PARDMemoryCtrl::chooseFromQueue(std::deque<SchedEntry> &queue)
+{
+    assert(!queue.empty());
+
+    // The queue is in arrival order, so the first starving request is
+    // also the oldest one
+    auto best = queue.begin();
+    while (best != queue.end() && hasHazard(*best))
+        ++best;
+    if (best == queue.end() || schedPolicy == Enums::pard_fcfs ||
+        curTick() - best->entryTick >= starvationLimit)
+        return best;
+
+    bool best_hit = shadowOf(best->addr).isRowHit(best->addr);
+    bool by_priority = (schedPolicy == Enums::pard_prio_frfcfs);
+
+    for (auto it = best + 1; it != queue.end(); ++it) {
+        if (by_priority && it->priority != best->priority) {
+            if (it->priority > best->priority && !hasHazard(*it)) {
+                best = it;
+                best_hit = shadowOf(it->addr).isRowHit(it->addr);
+            }
+            continue;
+        }
+
+        // FR-FCFS among requests of the same priority
+        if (!best_hit && shadowOf(it->addr).isRowHit(it->addr) &&
+            !hasHazard(*it)) {
+            best = it;
+            best_hit = true;
+        }
+    }
+
+    return best;
+}
+
+void
+PARDMemoryCtrl::trySchedule()
+{
+    while (!waitingForRetry && outstanding < maxOutstanding) {
+        std::deque<SchedEntry> *queue = chooseQueue();
+        if (!queue)
+            break;
+
+        auto it = chooseFromQueue(*queue);
+        if (it == queue->end()) {
+            // the oldest request of all is in the other queue, and
+            // never waits for anyone
+            queue = (queue == &readQueue) ? &writeQueue : &readQueue;
+            it = chooseFromQueue(*queue);
+            assert(it != queue->end());
+        }
+        DPRINTF(PARDMemoryCtrl, "schedule DSid#%d 0x%x, prio %d, "
+                "waited %d ticks\n", it->DSid, it->addr, it->priority,
+                curTick() - it->entryTick);
+
+        if (!sendToDRAM(*it)) {
+            waitingForRetry = true;
+            break;
+        }
+        queue->erase(it);
+
+        // There is room in the queues again
+        if (!throttledDSids.empty())
+            scheduleRefill(curTick());
+        if (retryReq && canRetry()) {
+            retryReq = false;
+            port.sendRetry();
+        }
+    }
+
+    checkDrained();
+}
+
+bool
+PARDMemoryCtrl::canRetry() const
+{
+    // a request refused by a full scheduler queue, or by the DRAM
+    // controller, is retried as soon as the queues move
+    return !retryHeld ||
+           buckets[retryDSid].pending.size() < throttleQueueSize;
+}
+
+void
+PARDMemoryCtrl::refillBucket(TokenBucket &bucket)
+{
+    bucket.tokens += (curTick() - bucket.lastRefill) * bucket.rate;
+    if (bucket.tokens > bucket.burst)
+        bucket.tokens = bucket.burst;
+    bucket.lastRefill = curTick();
+}
+
+void
+PARDMemoryCtrl::releaseThrottled()
+{
+    // Round-robin among throttled DSids, one request each turn, until
+    // no one can make progress
+    unsigned stalled = 0;
+    while (!throttledDSids.empty() && stalled < throttledDSids.size()) {
+        uint16_t DSid = throttledDSids.front();
+        throttledDSids.pop_front();
+
+        TokenBucket &bucket = buckets[DSid];
+        assert(!bucket.pending.empty());
+        SchedEntry &entry = bucket.pending.front();
+        bool isRead = entry.pkt->isRead();
+        std::deque<SchedEntry> &queue = isRead ? readQueue : writeQueue;
+        unsigned queue_size = isRead ? readQueueSize : writeQueueSize;
+
+        if (bucket.rate > 0)
+            refillBucket(bucket);
+
+        if ((bucket.rate > 0 && bucket.tokens < 0) ||
+            queue.size() >= queue_size) {
+            throttledDSids.push_back(DSid);
+            stalled++;
+            continue;
+        }
+
+        DPRINTF(PARDMemoryCtrl, "DSid#%d release 0x%x, tokens %f\n",
+                DSid, entry.addr, bucket.tokens);
+        if (bucket.rate > 0)
+            bucket.tokens -= entry.pkt->getSize();
+        // the time spent here is not counted by starvation guard
+        entry.entryTick = curTick();
+        queue.push_back(entry);
+        bucket.pending.pop_front();
+        stalled = 0;
+
+        if (!bucket.pending.empty())
+            throttledDSids.push_back(DSid);
+
+        if (retryReq && retryHeld && retryDSid == DSid && canRetry()) {
+            retryReq = false;
+            port.sendRetry();
+        }
+    }
+}
+
+void
+PARDMemoryCtrl::scheduleRefill(Tick when)
+{
+    if (!refillEvent.scheduled())
+        schedule(refillEvent, when);
+    else if (refillEvent.when() > when)
+        reschedule(refillEvent, when);
+}
+
+void
+PARDMemoryCtrl::processRefillEvent()
+{
+    releaseThrottled();
+
+    if (!sendEvent.scheduled() &&
+        (!readQueue.empty() || !writeQueue.empty()))
+        schedule(sendEvent, curTick());
+
+    // Wake up again when the first DSid gets out of debt, requests
+    // blocked by full scheduler queues are woken up by trySchedule()
+    Tick when = MaxTick;
+    for (auto DSid : throttledDSids) {
+        const TokenBucket &bucket = buckets[DSid];
+        if (bucket.rate > 0 && bucket.tokens < 0) {
+            Tick wait = (Tick)(-bucket.tokens / bucket.rate) + 1;
+            when = std::min(when, curTick() + wait);
+        }
+    }
+    if (when != MaxTick)
+        scheduleRefill(when);
+
+    checkDrained();
+}
+
+void
+PARDMemoryCtrl::setBandwidthLimit(uint16_t DSid, uint64_t rate,
+                                  uint64_t burst)
+{
+    if (DSid >= buckets.size()) {
+        warn("%s: DSid 0x%x out of bandwidth regulator table\n",
+             name(), DSid);
+        return;
+    }
+
+    DPRINTF(PARDMemoryCtrl, "DSid#%d bandwidth limit: %d B/s, "
+            "burst %d B\n", DSid, rate, burst);
+
+    TokenBucket &bucket = buckets[DSid];
+    bucket.rate = (double)rate / SimClock::Frequency;
+    bucket.burst = burst;
+    bucket.tokens = burst;
+    bucket.lastRefill = curTick();
+
+    // flush held requests under the new limit, the ones still held
+    // are released by the refill event
+    if (!bucket.pending.empty()) {
+        releaseThrottled();
+        if (!sendEvent.scheduled() &&
+            (!readQueue.empty() || !writeQueue.empty()))
+            schedule(sendEvent, curTick());
+        scheduleRefill(curTick());
+    }
+}
+
+void
+PARDMemoryCtrl::setSchedPolicy(Enums::PARDMemSched policy)
+{
+    DPRINTF(PARDMemoryCtrl, "scheduler policy: %s\n",
+            Enums::PARDMemSchedStrings[policy]);
+    schedPolicy = policy;
+}
+
+void
+PARDMemoryCtrl::setMaxOutstanding(unsigned max)
+{
+    if (max == 0) {
+        warn("%s: ignore zero max_outstanding\n", name());
+        return;
+    }
+    maxOutstanding = max;
+    if (!sendEvent.scheduled())
+        schedule(sendEvent, curTick());
+}
+
+void
+PARDMemoryCtrl::functionalOverlap(PacketPtr pkt, bool is_read,
+                                  const SchedEntry &entry)
+{
+    PacketPtr write = entry.pkt;
+    if (!write->isWrite() || !write->hasData())
+        return;
+
+    Addr start = std::max(pkt->getAddr(), entry.addr);
+    Addr end = std::min(pkt->getAddr() + pkt->getSize(),
+                        entry.addr + write->getSize());
+    if (start >= end)
+        return;
+
+    uint8_t *pkt_data = pkt->getPtr<uint8_t>() + (start - pkt->getAddr());
+    uint8_t *write_data = write->getPtr<uint8_t>() + (start - entry.addr);
+    if (is_read)
+        memcpy(pkt_data, write_data, end - start);
+    else
+        memcpy(write_data, pkt_data, end - start);
 }
 
 void
 PARDMemoryCtrl::recvFunctional(PacketPtr pkt)
 {
     Addr orig_addr = pkt->getAddr();
+    bool is_read = pkt->isRead();
+    bool is_write = pkt->isWrite();
+
     pkt->setAddr(remapAddr(pkt->getDSid(), orig_addr));
     pkt->firstWordDelay = pkt->lastWordDelay = 0;
     internal_port.sendFunctional(pkt);
+
+    // Queued and held writes are newer than the memory contents:
+    // reads see them on top of memory in arrival order, writes update
+    // them so they do not overwrite the functional data later
+    if (is_read || is_write) {
+        for (auto &entry : writeQueue)
+            functionalOverlap(pkt, is_read, entry);
+        // held requests of a DSid are newer than its queued ones
+        for (auto DSid : throttledDSids) {
+            for (auto &entry : buckets[DSid].pending)
+                functionalOverlap(pkt, is_read, entry);
+        }
+    }
+
     pkt->setAddr(orig_addr);
 }
 
 bool
 PARDMemoryCtrl::recvTimingResp(PacketPtr pkt)
 {
-    RequestState *req_state =
-        dynamic_cast<RequestState*>(pkt->senderState);
+    RequestState *req_state = RequestState::peek(pkt, this);
 
     // panic if failed to restore initial sender state
     panic_if(!req_state,
@@ -105,8 +1028,14 @@ PARDMemoryCtrl::recvTimingResp(PacketPtr pkt)
              name());
     pkt->popSenderState();
 
+    assert(outstanding);
+    outstanding--;
+
     PortID dest = pkt->getDest();
     Addr remapped_addr = pkt->getAddr();
+    uint16_t DSid = pkt->getDSid();
+    bool isRead = pkt->isRead();
+    bool accounted = isRead || pkt->isWrite();
 
     pkt->setDest(req_state->origSrc);
     pkt->setAddr(req_state->origAddr);
@@ -118,6 +1047,13 @@ PARDMemoryCtrl::recvTimingResp(PacketPtr pkt)
     // If packet successfully sent delete the sender state otherwise
     // restore state
     if (successful) {
+        if (accounted) {
+            Tick mem_acc_lat = curTick() - req_state->entryTick;
+            Tick bus_lat = req_state->bursts * shadows[0].tBURST;
+            cp->recordResponse(DSid, isRead, mem_acc_lat, bus_lat,
+                               rowAccessLatency(req_state->bursts,
+                                                req_state->rowHits));
+        }
         delete req_state;
     } else {
         // Don't delete anything and let the packet look like we did
@@ -125,8 +1061,14 @@ PARDMemoryCtrl::recvTimingResp(PacketPtr pkt)
         pkt->pushSenderState(req_state);
         pkt->setDest(dest);
         pkt->setAddr(remapped_addr);
+        outstanding++;
     }
 
+    // A slot in DRAM controller is freed
+    if (successful && !sendEvent.scheduled() &&
+        (!readQueue.empty() || !writeQueue.empty()))
+        schedule(sendEvent, curTick());
+
     return successful;
 }
 
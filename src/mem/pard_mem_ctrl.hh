@@ -1,20 +1,38 @@
 #ifndef __MEM_PARD_MEMORYCTRL_HH__
 #define __MEM_PARD_MEMORYCTRL_HH__
 
+#include <deque>
+#include <list>
+
+#include "enums/PARDMemSched.hh"
 #include "mem/abstract_mem.hh"
+#include "mem/pard_dram_shadow.hh"
+#include "mem/pard_mem_backing.hh"
+#include "mem/pard_mem_ctrl_cp.hh"
+#include "mem/pard_sender_state.hh"
 #include "params/PARDMemoryCtrl.hh"
+#include "prm/interfaces.hh"
+
+class System;
 
-class PARDMemoryCtrl : public MemObject
+class PARDMemoryCtrl : public MemObject, public ICommandHandler
 {
   private:
 
-    class RequestState : public Packet::SenderState
+    class RequestState : public PooledSenderState<RequestState>
     {
       public:
         const PortID origSrc;
         const Addr origAddr;
-        RequestState(PortID orig_src, Addr orig_addr)
-            : origSrc(orig_src), origAddr(orig_addr)
+        // per-DSid statistics of this request
+        const Tick entryTick;
+        unsigned bursts;
+        unsigned rowHits;
+        RequestState(const PARDMemoryCtrl *owner, PortID orig_src,
+                     Addr orig_addr)
+            : PooledSenderState<RequestState>(owner),
+              origSrc(orig_src), origAddr(orig_addr), entryTick(curTick()),
+              bursts(0), rowHits(0)
         { }
     };
 
@@ -69,19 +87,216 @@ class PARDMemoryCtrl : public MemObject
         { return memory.recvTimingResp(pkt); }
 
         virtual void recvRetry()
-        { return memoryPort.sendRetry(); }
+        { memory.recvReqRetry(); }
     };
 
     MemoryPort port;
     InternalPort internal_port;
     std::vector<AbstractMemory *> memories;
 
+    PARDMemoryCtrlCP *cp;
+
+    /**
+     * Internal memories are channels of the same size, laid out
+     * contiguously from memBase. Each DSid is either interleaved over
+     * all channels at channelIntlvSize granularity, or pinned to one
+     * channel.
+     */
+    Addr memBase;
+    Addr channelSize;
+    const Addr channelIntlvSize;
+
+    /** Shadow row-buffer state of each channel */
+    std::vector<DRAMRowShadow> shadows;
+
+    DRAMRowShadow &shadowOf(Addr addr)
+    { return shadows[(addr - memBase) / channelSize]; }
+    const DRAMRowShadow &shadowOf(Addr addr) const
+    { return shadows[(addr - memBase) / channelSize]; }
+
+    /**
+     * Front-end request scheduler.
+     *
+     * Requests are queued here before entering the DRAM controller,
+     * so they can be reordered by DSid priority and row-buffer
+     * locality. Only a bounded number of requests are kept
+     * outstanding in the DRAM controller, which keeps its own
+     * (DSid-unaware) queues short. With the pard_fcfs policy requests
+     * are passed through in arrival order. A request overlapping an
+     * older queued one (read after write, write after read or write)
+     * is never reordered ahead of it.
+     */
+    struct SchedEntry {
+        PacketPtr pkt;
+        uint16_t DSid;
+        Addr addr;          // remapped address
+        uint64_t priority;  // snapshot of effective_priority
+        Tick entryTick;
+        uint64_t seqNum;    // arrival order
+    };
+
+    uint64_t nextSeqNum;
+
+    std::deque<SchedEntry> readQueue;
+    std::deque<SchedEntry> writeQueue;
+
+    const unsigned readQueueSize;
+    const unsigned writeQueueSize;
+    const unsigned writeHighThreshold;
+    const unsigned writeLowThreshold;
+
+    Enums::PARDMemSched schedPolicy;
+    Tick starvationLimit;
+    unsigned maxOutstanding;
+
+    /** Requests in DRAM controller waiting for response */
+    unsigned outstanding;
+
+    bool drainingWrites;
+    /** Upstream is waiting for a retry from us */
+    bool retryReq;
+    /**
+     * The request was refused as the pending queue of retryDSid was
+     * full, retry only once it has room.
+     */
+    bool retryHeld;
+    uint16_t retryDSid;
+    /** DRAM controller rejected a request, wait for its retry */
+    bool waitingForRetry;
+
+    /** Whether the refused request would be taken now */
+    bool canRetry() const;
+
+    DrainManager *drainManager;
+
+    void processSendEvent();
+    EventWrapper<PARDMemoryCtrl, &PARDMemoryCtrl::processSendEvent> sendEvent;
+
+    /**
+     * Per-DSid bandwidth regulator.
+     *
+     * Each regulated DSid owns a token bucket filled at `rate' bytes
+     * per tick up to `burst' bytes. A request is admitted while the
+     * bucket is not in debt, and its size is then taken from the
+     * bucket. Requests of a DSid in debt are held in its own bounded
+     * pending queue, and released to the scheduler round-robin among
+     * DSids as tokens are refilled, so one noisy LDom neither gets
+     * through nor blocks the others.
+     */
+    struct TokenBucket {
+        double rate;        // bytes per tick, 0 means unlimited
+        double burst;       // bytes
+        double tokens;
+        Tick lastRefill;
+        std::deque<SchedEntry> pending;
+    };
+
+    /** Token buckets, indexed by DSid */
+    std::vector<TokenBucket> buckets;
+
+    /** DSids with pending requests, in round-robin order */
+    std::list<uint16_t> throttledDSids;
+
+    const unsigned throttleQueueSize;
+
+    TokenBucket *getBucket(uint16_t DSid)
+    {
+        return (DSid < buckets.size() && buckets[DSid].rate > 0)
+               ? &buckets[DSid] : NULL;
+    }
+    void refillBucket(TokenBucket &bucket);
+    void scheduleRefill(Tick when);
+
+    void processRefillEvent();
+    EventWrapper<PARDMemoryCtrl, &PARDMemoryCtrl::processRefillEvent>
+        refillEvent;
+
+  public:
+
+    /**
+     * DSid remapping entry: guest physical address range [base, base+size)
+     * of a DSid is mapped to [offset, offset+size) of internal memories.
+     * The LDom holds [offset, offset+span), larger than size if it is
+     * bank colored, see Layout.
+     */
+    struct RemapEntry {
+        Addr base;
+        Addr size;
+        Addr offset;
+        Addr span;
+        bool valid;
+    };
+
+  protected:
+
+    /**
+     * DSid remapping table, indexed by DSid directly, so lookup cost on
+     * the timing path is independent of the number of LDoms.
+     */
+    std::vector<RemapEntry> remapTable;
+
+    /**
+     * Bank coloring of each DSid, indexed by DSid, applied after
+     * remapping. Empty color means no restriction.
+     */
+    std::vector<DRAMRowShadow::BankColor> bankColors;
+
+    /** Channel of each DSid, or ChannelInterleave, indexed by DSid */
+    std::vector<int> channelPolicy;
+
+    /**
+     * Per-LDom backing stores. A DSid is rebound only when its layout
+     * moves its memory to other host regions, and its memory contents
+     * are then not preserved, unless file backed. Only LDoms occupying one
+     * contiguous range per channel, i.e. not bank colored, get their
+     * own backing; segments of LDoms never overlap (checkLayout()).
+     */
+    System *system;
+    LDomBackingStore backing;
+    /** Host backing stores are created, i.e. after construction */
+    bool backingReady;
+
+    /**
+     * Range [local, local+local_size) that the segment [offset,
+     * offset+size) under channel policy occupies in each of its
+     * channels, false if it is not one contiguous range per channel.
+     */
+    bool channelWindow(Addr offset, Addr size, int channel,
+                       Addr *local, Addr *local_size) const;
+
+    /**
+     * Local range [lo, hi) the segment may touch in each of its
+     * channels, false if the segment does not fit in them.
+     */
+    bool footprint(Addr offset, Addr size, int channel,
+                   Addr *lo, Addr *hi) const;
+
+    /**
+     * Build the bank color of mask for the segment remap of DSid
+     * under channel policy, and set the span of remap to the rows the
+     * color needs. Warn and return false if the segment is not whole
+     * rows of every bank.
+     */
+    bool makeColor(uint16_t DSid, uint64_t mask, RemapEntry &remap,
+                   int channel, DRAMRowShadow::BankColor &color) const;
+
+    /** Host regions of the memory segment of DSid, false if scattered */
+    bool ldomRegions(uint16_t DSid,
+                     std::vector<LDomBackingStore::Region> &regions) const;
+    void rebindBacking(uint16_t DSid);
+
   public:
 
     PARDMemoryCtrl(const PARDMemoryCtrlParams* p);
 
     virtual void init();
 
+    unsigned int drain(DrainManager *dm);
+
+    // __override__ ICommandHandler::handleCommand()
+    virtual bool handleCommand(int cmd, uint64_t arg1, uint64_t arg2,
+                               uint64_t arg3);
+
     virtual BaseSlavePort&
     getSlavePort(const std::string& if_name, PortID idx = InvalidPortID)
     {
@@ -108,9 +323,128 @@ class PARDMemoryCtrl : public MemObject
     void recvFunctional(PacketPtr pkt);
     bool recvTimingReq(PacketPtr pkt);
     bool recvTimingResp(PacketPtr pkt);
+    void recvReqRetry();
+
+    /** Remap pkt and build its scheduler entry */
+    SchedEntry makeSchedEntry(PacketPtr pkt);
+
+    /** Try to pass a request to DRAM controller, true on success */
+    bool sendToDRAM(const SchedEntry &entry);
+
+    /** Pick the queue to serve next, NULL if both are empty */
+    std::deque<SchedEntry> *chooseQueue();
+    /**
+     * Pick the request to send next from a non-empty queue, end() if
+     * all of them wait for an older request of the other queue
+     */
+    std::deque<SchedEntry>::iterator
+    chooseFromQueue(std::deque<SchedEntry> &queue);
+
+    /** entry overlaps an older queued request it may not pass */
+    bool hasHazard(const SchedEntry &entry) const;
+
+    /** Copy the bytes of pkt overlapping queued write entry */
+    void functionalOverlap(PacketPtr pkt, bool is_read,
+                           const SchedEntry &entry);
+
+    void trySchedule();
+    void checkDrained();
+
+    /** Release held requests whose DSid have tokens again */
+    void releaseThrottled();
 
     virtual Addr remapAddr(uint16_t DSid, Addr addr) const;
-   
+
+    /**
+     * Update shadow row-buffer state with an access to the remapped
+     * range [addr, addr+size), return number of row hits.
+     */
+    unsigned accessRowShadow(Addr addr, unsigned size, unsigned *bursts);
+
+    /** Row access time of a request, used to estimate queueing latency */
+    Tick rowAccessLatency(unsigned bursts, unsigned rowHits) const
+    {
+        return rowHits * shadows[0].tCL +
+               (bursts - rowHits) * (shadows[0].tRCD + shadows[0].tCL);
+    }
+
+  public:
+
+    enum { ChannelInterleave = -1 };
+
+    /**
+     * Memory layout of an LDom: guest physical range [base, base+size)
+     * is remapped to segment [offset, offset+size) of the internal
+     * memories, interleaved over all channels (ChannelInterleave) or
+     * pinned to one channel, where the segment is taken modulo the
+     * channel size. bankMask restricts the LDom to the banks set in it
+     * (bit i is flat bank i, i.e. rank * banks_per_rank + bank, 0
+     * means all banks). A colored LDom of ways banks holds
+     * size*banks/ways of internal memory from offset, whole DRAM rows
+     * of every bank, and its addresses stay in those rows of its banks.
+     */
+    struct Layout {
+        Addr base;
+        Addr size;          // 0 keeps the segment in effect
+        Addr offset;
+        int channel;
+        uint64_t bankMask;
+    };
+
+    /**
+     * Layout interface, used by control plane to (re)program the
+     * memory layout of LDoms. The whole layout is applied at once and
+     * the LDom is rebound to its backing store once; false (and
+     * nothing changed) if the layout is rejected. Layouts should be
+     * set before the LDom starts, since memory contents are not
+     * migrated.
+     */
+    bool setLayout(uint16_t DSid, const Layout &layout);
+    /** Withdraw the layout of DSid, and its segment if remap is set */
+    void clearLayout(uint16_t DSid, bool remap);
+
+    /**
+     * Check that segment [offset, offset+size) of DSid under channel
+     * policy fits in the internal memories and overlaps no segment of
+     * another LDom on its channels. Warn and return false if not.
+     */
+    bool checkLayout(uint16_t DSid, Addr offset, Addr size,
+                     int channel) const;
+
+    /**
+     * Scheduler interface, used by control plane to configure the
+     * scheduler at runtime.
+     */
+    Enums::PARDMemSched getSchedPolicy() const { return schedPolicy; }
+    void setSchedPolicy(Enums::PARDMemSched policy);
+    Tick getStarvationLimit() const { return starvationLimit; }
+    void setStarvationLimit(Tick limit) { starvationLimit = limit; }
+    unsigned getMaxOutstanding() const { return maxOutstanding; }
+    void setMaxOutstanding(unsigned max);
+
+    /**
+     * Bandwidth regulator interface, rate in bytes per second, zero
+     * rate removes the limit.
+     */
+    void setBandwidthLimit(uint16_t DSid, uint64_t rate, uint64_t burst);
+
+    /**
+     * LDom memory interface: release host pages of DSid, or write its
+     * memory back to its backing file.
+     */
+    void dropLDomMemory(uint16_t DSid);
+    void syncLDomMemory(uint16_t DSid);
+
+    /** Channels are assumed to be identical */
+    const DRAMRowShadow &getRowShadow() const { return shadows[0]; }
+    unsigned getNumChannels() const { return memories.size(); }
+    uint64_t getMemorySize() const;
+
+    const RemapEntry *getRemapEntry(uint16_t DSid) const
+    {
+        return (DSid < remapTable.size() && remapTable[DSid].valid)
+               ? &remapTable[DSid] : NULL;
+    }
 };
 
 #endif	// __MEM_PARD_MEMORYCTRL_HH__
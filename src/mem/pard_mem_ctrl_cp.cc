@@ -0,0 +1,394 @@
+#include <cstddef>
+
+#include "debug/ControlPlane.hh"
+#include "mem/pard_mem_ctrl.hh"
+#include "mem/pard_mem_ctrl_cp.hh"
+#include "sim/core.hh"
+
+PARDMemoryCtrlCP::PARDMemoryCtrlCP(const Params *p)
+    : ControlPlane(p),
+      param_table_entries(p->param_table_entries),
+      stat_table_entries(p->stat_table_entries),
+      dsidIndex(p->param_table_entries),
+      statStartTick(p->stat_table_entries, 0),
+      lastReqTick(p->stat_table_entries, MaxTick),
+      appliedLayout(p->param_table_entries),
+      memctrl(NULL)
+{
+    panic_if(stat_table_entries < param_table_entries,
+             "%s: stat table (%d) smaller than param table (%d)\n",
+             name(), stat_table_entries, param_table_entries);
+
+    memset(&memInfo, 0, sizeof(memInfo));
+
+    // Allocate ConfigTable
+    paramTable = new struct MemCtrlParamEntry[param_table_entries];
+    statTable  = new struct MemCtrlStatEntry[stat_table_entries];
+    memset(paramTable, 0, sizeof(struct MemCtrlParamEntry)*param_table_entries);
+    memset(statTable,  0, sizeof(struct MemCtrlStatEntry) *stat_table_entries);
+}
+
+PARDMemoryCtrlCP::~PARDMemoryCtrlCP()
+{
+    delete[] paramTable;
+    delete[] statTable;
+}
+
+void
+PARDMemoryCtrlCP::regPARDMemoryCtrl(PARDMemoryCtrl *_memctrl)
+{
+    panic_if(memctrl, "%s already reg to %s\n",
+             name().c_str(), memctrl->name().c_str());
+    memctrl = _memctrl;
+
+    const DRAMRowShadow &shadow = memctrl->getRowShadow();
+    memInfo.memSize = memctrl->getMemorySize();
+    memInfo.burstSize = shadow.burstSize();
+    memInfo.rowBufferSize = shadow.rowBufferSize();
+    memInfo.banks = shadow.numBanks();
+    memInfo.peakBW = shadow.peakBW() * memctrl->getNumChannels();
+    memInfo.sched_policy = memctrl->getSchedPolicy();
+    memInfo.starvation_limit =
+        memctrl->getStarvationLimit() / SimClock::Int::ns;
+    memInfo.max_outstanding = memctrl->getMaxOutstanding();
+    memInfo.channels = memctrl->getNumChannels();
+}
+
+int
+PARDMemoryCtrlCP::findTableRow(uint16_t DSid) const
+{
+    return dsidIndex.find(DSid);
+}
+
+const MemCtrlParamEntry *
+PARDMemoryCtrlCP::getParamEntry(uint16_t DSid) const
+{
+    int row = findTableRow(DSid);
+    return (row < 0) ? NULL : &paramTable[row];
+}
+
+MemCtrlStatEntry *
+PARDMemoryCtrlCP::getStatEntry(uint16_t DSid)
+{
+    int row = findTableRow(DSid);
+    return (row < 0) ? NULL : &statTable[row];
+}
+
+void
+PARDMemoryCtrlCP::recordRequest(uint16_t DSid, bool isRead, unsigned size,
+                                unsigned bursts, unsigned rowHits)
+{
+    MemCtrlStatEntry *stat = getStatEntry(DSid);
+    if (!stat)
+        return;
+
+    int row = stat - statTable;
+    if (lastReqTick[row] != MaxTick)
+        stat->totGap += curTick() - lastReqTick[row];
+    lastReqTick[row] = curTick();
+
+    if (isRead) {
+        stat->readReqs++;
+        stat->readBursts += bursts;
+        stat->bytesReadDRAM += bursts * memInfo.burstSize;
+        stat->bytesReadSys += size;
+        stat->readRowHits += rowHits;
+        stat->rdQLen++;
+    } else {
+        stat->writeReqs++;
+        stat->writeBursts += bursts;
+        stat->bytesWritten += bursts * memInfo.burstSize;
+        stat->bytesWrittenSys += size;
+        stat->writeRowHits += rowHits;
+        stat->wrQLen++;
+    }
+}
+
+void
+PARDMemoryCtrlCP::recordRetry(uint16_t DSid, bool isRead)
+{
+    MemCtrlStatEntry *stat = getStatEntry(DSid);
+    if (!stat)
+        return;
+
+    if (isRead)
+        stat->numRdRetry++;
+    else
+        stat->numWrRetry++;
+}
+
+void
+PARDMemoryCtrlCP::recordThrottle(uint16_t DSid)
+{
+    MemCtrlStatEntry *stat = getStatEntry(DSid);
+    if (stat)
+        stat->throttledReqs++;
+}
+
+void
+PARDMemoryCtrlCP::recordResponse(uint16_t DSid, bool isRead, Tick memAccLat,
+                                 Tick busLat, Tick accessLat)
+{
+    MemCtrlStatEntry *stat = getStatEntry(DSid);
+    if (!stat)
+        return;
+
+    if (!isRead) {
+        if (stat->wrQLen)
+            stat->wrQLen--;
+        return;
+    }
+
+    if (stat->rdQLen)
+        stat->rdQLen--;
+
+    // like DRAMCtrl, latencies are only accounted for reads
+    stat->totMemAccLat += memAccLat;
+    stat->totBusLat += busLat;
+    if (memAccLat > busLat + accessLat)
+        stat->totQLat += memAccLat - busLat - accessLat;
+}
+
+void
+PARDMemoryCtrlCP::updateDerivedStats(int row)
+{
+    MemCtrlStatEntry &s = statTable[row];
+
+    uint64_t bursts = s.readBursts + s.writeBursts;
+    uint64_t reqs = s.readReqs + s.writeReqs;
+    double seconds = (double)(curTick() - statStartTick[row])
+                     / SimClock::Frequency;
+
+    // latencies are summed once per read request, see recordResponse
+    s.avgQLat      = s.readReqs ? s.totQLat / s.readReqs : 0;
+    s.avgBusLat    = s.readReqs ? s.totBusLat / s.readReqs : 0;
+    s.avgMemAccLat = s.readReqs ? s.totMemAccLat / s.readReqs : 0;
+
+    s.avgRdBW    = seconds > 0 ? s.bytesReadDRAM / seconds : 0;
+    s.avgWrBW    = seconds > 0 ? s.bytesWritten / seconds : 0;
+    s.avgRdBWSys = seconds > 0 ? s.bytesReadSys / seconds : 0;
+    s.avgWrBWSys = seconds > 0 ? s.bytesWrittenSys / seconds : 0;
+
+    s.peakBW = memInfo.peakBW;
+    if (s.peakBW) {
+        s.busUtilRead  = s.avgRdBW * 10000 / s.peakBW;
+        s.busUtilWrite = s.avgWrBW * 10000 / s.peakBW;
+        s.busUtil = s.busUtilRead + s.busUtilWrite;
+    }
+
+    s.readRowHitRate  = s.readBursts ?
+                        s.readRowHits * 10000 / s.readBursts : 0;
+    s.writeRowHitRate = s.writeBursts ?
+                        s.writeRowHits * 10000 / s.writeBursts : 0;
+    s.pageHitRate     = bursts ?
+                        (s.readRowHits + s.writeRowHits) * 10000 / bursts : 0;
+    s.avgGap = reqs ? s.totGap / reqs : 0;
+}
+
+void
+PARDMemoryCtrlCP::paramUpdated(int row, const MemCtrlParamEntry &old)
+{
+    MemCtrlParamEntry &entry = paramTable[row];
+    bool was_valid = old.flags & MEMCTRL_FLAG_VALID;
+    bool is_valid = entry.flags & MEMCTRL_FLAG_VALID;
+    bool commit = is_valid && (!was_valid || old.DSid != entry.DSid ||
+                               (entry.flags & MEMCTRL_FLAG_COMMIT));
+    entry.flags &= ~MEMCTRL_FLAG_COMMIT;
+
+    entry.effective_priority = entry.priority;
+
+    if (memctrl) {
+        // withdraw the layout this row programmed for another DSid
+        AppliedLayout &applied = appliedLayout[row];
+        if (applied.valid && (!is_valid || applied.DSid != entry.DSid)) {
+            memctrl->clearLayout(applied.DSid, applied.ownsSegment);
+            applied.valid = false;
+        }
+
+        // apply the layout fields together, a rejected layout leaves
+        // the row invalid
+        if (commit) {
+            PARDMemoryCtrl::Layout layout;
+            layout.base = entry.addr_base;
+            layout.size = entry.addr_size;
+            layout.offset = entry.addr_offset;
+            layout.channel = entry.channel_policy ?
+                             (int)entry.channel_policy - 1 :
+                             PARDMemoryCtrl::ChannelInterleave;
+            layout.bankMask = entry.row_buffer_mask;
+            if (memctrl->setLayout(entry.DSid, layout)) {
+                applied.ownsSegment = entry.addr_size ||
+                                      (applied.valid && applied.ownsSegment);
+                applied.valid = true;
+                applied.DSid = entry.DSid;
+            } else {
+                warn("PARDMemoryCtrlCP: DSid#%d layout rejected, row %d "
+                     "left invalid", entry.DSid, row);
+                if (applied.valid)
+                    memctrl->clearLayout(applied.DSid, applied.ownsSegment);
+                applied.valid = false;
+                entry.flags &= ~MEMCTRL_FLAG_VALID;
+                is_valid = false;
+            }
+        }
+    }
+
+    dsidIndex.set(row, is_valid ? entry.DSid : -1);
+
+    // (re)bind statistics row to this DSid
+    if (is_valid && (!was_valid || old.DSid != entry.DSid)) {
+        memset(&statTable[row], 0, sizeof(struct MemCtrlStatEntry));
+        statTable[row].DSid = entry.DSid;
+        statTable[row].flags = MEMCTRL_FLAG_VALID;
+        statStartTick[row] = curTick();
+        lastReqTick[row] = MaxTick;
+    } else if (!is_valid) {
+        statTable[row].flags &= ~MEMCTRL_FLAG_VALID;
+    }
+
+    if (!memctrl)
+        return;
+
+    // withdraw or (re)program bandwidth limit
+    if (was_valid && old.bw_limit &&
+        (!is_valid || old.DSid != entry.DSid))
+        memctrl->setBandwidthLimit(old.DSid, 0, 0);
+    if (is_valid &&
+        (!was_valid || old.DSid != entry.DSid ||
+         old.bw_limit != entry.bw_limit || old.bw_burst != entry.bw_burst) &&
+        (entry.bw_limit || (was_valid && old.bw_limit)))
+        memctrl->setBandwidthLimit(entry.DSid, entry.bw_limit * 1000000,
+                                   entry.bw_burst);
+}
+
+void
+PARDMemoryCtrlCP::updateSchedConfig(unsigned offset, uint64_t data)
+{
+    if (offset == offsetof(MemCtrlInfo, sched_policy)) {
+        if (data >= Enums::Num_PARDMemSched) {
+            warn("PARDMemoryCtrlCP: unknown sched policy %d", data);
+            return;
+        }
+        memInfo.sched_policy = data;
+        if (memctrl)
+            memctrl->setSchedPolicy((Enums::PARDMemSched)data);
+    } else if (offset == offsetof(MemCtrlInfo, starvation_limit)) {
+        memInfo.starvation_limit = data;
+        if (memctrl)
+            memctrl->setStarvationLimit(data * SimClock::Int::ns);
+    } else if (offset == offsetof(MemCtrlInfo, max_outstanding)) {
+        if (data == 0) {
+            warn("PARDMemoryCtrlCP: max_outstanding must be non-zero");
+            return;
+        }
+        memInfo.max_outstanding = data;
+        if (memctrl)
+            memctrl->setMaxOutstanding(data);
+    } else {
+        warn("PARDMemoryCtrlCP: sysinfo offset 0x%x is read-only", offset);
+    }
+}
+
+uint64_t *
+PARDMemoryCtrlCP::parseAddr(uint32_t addr)
+{
+    char *ptr = NULL;
+    int offset;
+
+    switch (addr & ADDRTYPE_MASK)
+    {
+      case ADDRTYPE_CFGTBL:
+        {
+            int row = cfgtbl_addr2row(addr);
+            offset = cfgtbl_addr2offset(addr);
+
+            switch (cfgtbl_addr2type(addr)) {
+              case CFGTBL_TYPE_PARAM:
+                if ((row < param_table_entries) &&
+                    (offset <= sizeof(struct MemCtrlParamEntry) - sizeof(uint64_t)))
+                    ptr = (char *)&paramTable[row];
+                break;
+              case CFGTBL_TYPE_STAT:
+                if ((row < stat_table_entries) &&
+                    (offset <= sizeof(struct MemCtrlStatEntry) - sizeof(uint64_t)))
+                    ptr = (char *)&statTable[row];
+                break;
+            }
+        }
+        break;
+      case ADDRTYPE_SYSINFO:
+        offset = sysinfo_addr2offset(addr);
+        if (offset <= sizeof(memInfo) - sizeof(uint64_t))
+            ptr = (char *)&memInfo;
+        break;
+    }
+
+    return (ptr ? ((uint64_t *)(ptr + offset)) : NULL);
+}
+
+uint64_t
+PARDMemoryCtrlCP::queryTable(uint16_t DSid, uint32_t addr)
+{
+    uint64_t *pdata;
+
+    DPRINTF(ControlPlane, "queryTable(DSid=%d, addr=0x%x)\n",
+            DSid, addr);
+
+    if (isTriggerAddr(addr))
+        return queryTrigger(addr);
+
+    pdata = parseAddr(addr);
+    if (!pdata) {
+        warn("PARDMemoryCtrlCP: unknown addr 0x%x", addr);
+        return 0xFFFFFFFFFFFFFFFF;
+    }
+
+    if ((addr & ADDRTYPE_MASK) == ADDRTYPE_CFGTBL &&
+        cfgtbl_addr2type(addr) == CFGTBL_TYPE_STAT)
+        updateDerivedStats(cfgtbl_addr2row(addr));
+
+    return *pdata;
+}
+
+void
+PARDMemoryCtrlCP::updateTable(uint16_t DSid, uint32_t addr, uint64_t data)
+{
+    uint64_t *pdata;
+
+    DPRINTF(ControlPlane, "updateTable(DSid=%d, addr=0x%x, data=0x%x)\n",
+            DSid, addr, data);
+
+    if (isTriggerAddr(addr)) {
+        updateTrigger(addr, data);
+        return;
+    }
+
+    pdata = parseAddr(addr);
+    if (!pdata) {
+        warn("PARDMemoryCtrlCP: unknown addr 0x%x", addr);
+        return;
+    }
+
+    if ((addr & ADDRTYPE_MASK) == ADDRTYPE_SYSINFO) {
+        updateSchedConfig(sysinfo_addr2offset(addr), data);
+        return;
+    }
+
+    // only parameter table is writable
+    if ((addr & ADDRTYPE_MASK) != ADDRTYPE_CFGTBL ||
+        cfgtbl_addr2type(addr) != CFGTBL_TYPE_PARAM) {
+        warn("PARDMemoryCtrlCP: addr 0x%x is read-only", addr);
+        return;
+    }
+
+    int row = cfgtbl_addr2row(addr);
+    MemCtrlParamEntry old = paramTable[row];
+    *pdata = data;
+    paramUpdated(row, old);
+}
+
+PARDMemoryCtrlCP *
+PARDMemoryCtrlCPParams::create()
+{
+    return new PARDMemoryCtrlCP(this);
+}
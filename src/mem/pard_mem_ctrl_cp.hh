@@ -0,0 +1,195 @@
+/**
+ * PARDg5-V Memory Controller Control Plane
+ *
+ * Uses the same ConfigTable/SystemInfo address mapping as
+ * PARDg5VSystemCP (see arch/x86/pardg5v_system_cp.hh). Row #i of the
+ * statistics table holds the counters of the DSid in row #i of the
+ * parameter table; it is reset when the parameter row becomes valid.
+ *
+ * Counters are collected by PARDMemoryCtrl on its way to/from DRAM:
+ *   - row hits come from a shadow row-buffer model (DRAMRowShadow);
+ *   - rdQLen/wrQLen are the current number of outstanding requests;
+ *   - totQLat is estimated as memory access latency minus bus and
+ *     row access time;
+ *   - avg* and bandwidth fields are computed on query, bandwidth is
+ *     in bytes/s, all utilization and hit rates are in 0.01% units.
+ *
+ * row_buffer_mask restricts the DSid to a set of DRAM banks (bit i is
+ * flat bank i = rank * banks_per_rank + bank), 0 means all banks, the
+ * resulting per-DSid row hit rate is reported in the statistics table.
+ * Colored addresses stay in the DRAM rows of the DSid, so its memory
+ * must be whole rows.
+ *
+ * The layout fields (addr_*, row_buffer_mask, channel_policy) are
+ * applied together when the row becomes valid or changes DSid, or
+ * when MEMCTRL_FLAG_COMMIT is written to a valid row; writing them to
+ * a valid row alone has no effect. The flag clears itself. A layout
+ * that does not fit the memory or overlaps the segment of another
+ * valid LDom is rejected with a warning and the row is left invalid.
+ *
+ * Larger priority value means higher priority. The scheduler fields
+ * of SystemInfo are writable, the rest of SystemInfo is read-only.
+ *
+ * Triggers (see prm/ControlPlane.hh) may watch any statistics field
+ * and rewrite any parameter field of their DSid, e.g. lower bw_limit
+ * of a batch DSid when avgMemAccLat of a latency critical DSid grows.
+ */
+
+#ifndef __MEM_PARD_MEMORYCTRL_CP_HH__
+#define __MEM_PARD_MEMORYCTRL_CP_HH__
+
+#include <vector>
+
+#include "params/PARDMemoryCtrlCP.hh"
+#include "prm/ControlPlane.hh"
+#include "prm/DSidIndex.hh"
+
+#define MEMCTRL_FLAG_VALID	0x8000
+#define MEMCTRL_FLAG_COMMIT	0x4000
+
+struct MemCtrlParamEntry {
+    uint16_t DSid;
+    uint16_t flags;
+    uint32_t __padding;
+    uint64_t priority;
+    uint64_t effective_priority;
+    uint64_t row_buffer_mask;
+    // remapping of this DSid, not programmed if addr_size is 0
+    uint64_t addr_base;
+    uint64_t addr_size;
+    uint64_t addr_offset;
+    // bandwidth limit in MB/s (0 means unlimited) and burst in bytes
+    uint64_t bw_limit;
+    uint64_t bw_burst;
+    // 0: interleaved over all channels, c+1: pinned to channel c
+    uint64_t channel_policy;
+};
+
+struct MemCtrlStatEntry {
+    uint16_t DSid;
+    uint16_t flags;
+    uint32_t __padding;
+    // same layout as CPA_MEMCNTRL_IOCADDR_STATS
+    uint64_t readReqs;
+    uint64_t writeReqs;
+    uint64_t readBursts;
+    uint64_t writeBursts;
+    uint64_t bytesReadDRAM;
+    uint64_t bytesReadWrQ;
+    uint64_t bytesWritten;
+    uint64_t bytesReadSys;
+    uint64_t bytesWrittenSys;
+    uint64_t servicedByWrQ;
+    uint64_t mergedWrBursts;
+    uint64_t neitherReadNorWrite;
+    uint64_t numRdRetry;
+    uint64_t numWrRetry;
+    uint64_t totGap;
+    uint64_t rdQLen;
+    uint64_t wrQLen;
+    uint64_t totQLat;
+    uint64_t totMemAccLat;
+    uint64_t totBusLat;
+    uint64_t avgQLat;
+    uint64_t avgBusLat;
+    uint64_t avgMemAccLat;
+    uint64_t avgRdBW;
+    uint64_t avgWrBW;
+    uint64_t avgRdBWSys;
+    uint64_t avgWrBWSys;
+    uint64_t peakBW;
+    uint64_t busUtil;
+    uint64_t busUtilRead;
+    uint64_t busUtilWrite;
+    uint64_t readRowHits;
+    uint64_t writeRowHits;
+    uint64_t readRowHitRate;
+    uint64_t writeRowHitRate;
+    uint64_t avgGap;
+    uint64_t pageHitRate;
+    // requests held by bandwidth regulator
+    uint64_t throttledReqs;
+};
+
+struct MemCtrlInfo {
+    uint64_t memSize;
+    uint64_t burstSize;
+    uint64_t rowBufferSize;
+    uint64_t banks;         // per channel
+    uint64_t peakBW;        // all channels
+    // scheduler configuration, writable
+    uint64_t sched_policy;          // Enums::PARDMemSched
+    uint64_t starvation_limit;      // in ns
+    uint64_t max_outstanding;
+    uint64_t channels;
+};
+
+class PARDMemoryCtrl;
+
+class PARDMemoryCtrlCP : public ControlPlane
+{
+  protected:
+    int param_table_entries;
+    int stat_table_entries;
+
+    struct MemCtrlParamEntry *paramTable;
+    struct MemCtrlStatEntry  *statTable;
+    struct MemCtrlInfo memInfo;
+    DSidIndex dsidIndex;
+
+    // Per stat row bookkeeping, not visible through CPN
+    std::vector<Tick> statStartTick;
+    std::vector<Tick> lastReqTick;
+
+    /** Layout programmed to memctrl by each param row */
+    struct AppliedLayout {
+        bool valid;
+        uint16_t DSid;
+        bool ownsSegment;   // the segment was programmed by the row
+    };
+    std::vector<AppliedLayout> appliedLayout;
+
+    PARDMemoryCtrl *memctrl;
+
+  public:
+    typedef PARDMemoryCtrlCPParams Params;
+    PARDMemoryCtrlCP(const Params *p);
+    ~PARDMemoryCtrlCP();
+
+    void regPARDMemoryCtrl(PARDMemoryCtrl *_memctrl);
+
+  public:
+    const MemCtrlParamEntry *getParamEntry(uint16_t DSid) const;
+    MemCtrlStatEntry *getStatEntry(uint16_t DSid);
+
+    /**
+     * Statistics interface, called by PARDMemoryCtrl.
+     */
+    void recordRequest(uint16_t DSid, bool isRead, unsigned size,
+                       unsigned bursts, unsigned rowHits);
+    void recordRetry(uint16_t DSid, bool isRead);
+    void recordThrottle(uint16_t DSid);
+    void recordResponse(uint16_t DSid, bool isRead, Tick memAccLat,
+                        Tick busLat, Tick accessLat);
+
+    virtual uint64_t queryTable(uint16_t DSid, uint32_t addr);
+    virtual void updateTable(uint16_t DSid, uint32_t addr, uint64_t data);
+
+  protected:
+    virtual int findTableRow(uint16_t DSid) const;
+    virtual size_t statEntrySize() const
+    { return sizeof(struct MemCtrlStatEntry); }
+    virtual int statTableEntries() const { return stat_table_entries; }
+
+  private:
+    uint64_t *parseAddr(uint32_t addr);
+    void updateDerivedStats(int row);
+    void paramUpdated(int row, const MemCtrlParamEntry &old);
+    void updateSchedConfig(unsigned offset, uint64_t data);
+
+  protected:
+    const Params *param() const
+    { return dynamic_cast<const Params *>(_params); }
+};
+
+#endif	// __MEM_PARD_MEMORYCTRL_CP_HH__
@@ -0,0 +1,45 @@
+#include "mem/pard_cache_cp.hh"
+#include "mem/pard_prefetcher.hh"
+
+PARDStridePrefetcher::PARDStridePrefetcher(const Params *p)
+    : StridePrefetcher(p), cp(NULL)
+{
+}
+
+void
+PARDStridePrefetcher::calculatePrefetch(PacketPtr &pkt,
+                                        std::list<Addr> &addresses,
+                                        std::list<Cycles> &delays)
+{
+    StridePrefetcher::calculatePrefetch(pkt, addresses, delays);
+
+    if (!cp)
+        return;
+
+    unsigned degree = cp->prefetchDegree(pkt->getDSid(), addresses.size());
+    if (degree < addresses.size()) {
+        addresses.resize(degree);
+        delays.resize(degree);
+    }
+}
+
+unsigned
+PARDStridePrefetcher::tagPending(uint16_t DSid)
+{
+    // prefetches are queued in order, the new ones have no DSid yet;
+    // the request is tagged as well, as the miss sent to memory for a
+    // prefetch takes its DSid from the request
+    unsigned tagged = 0;
+    for (auto it = pf.rbegin(); it != pf.rend() && !(*it)->hasDSid(); ++it) {
+        (*it)->setDSid(DSid);
+        (*it)->req->setDSid(DSid);
+        tagged++;
+    }
+    return tagged;
+}
+
+PARDStridePrefetcher *
+PARDStridePrefetcherParams::create()
+{
+    return new PARDStridePrefetcher(this);
+}
@@ -0,0 +1,40 @@
+#ifndef __MEM_PARD_PREFETCHER_HH__
+#define __MEM_PARD_PREFETCHER_HH__
+
+#include "mem/cache/prefetch/stride.hh"
+#include "params/PARDStridePrefetcher.hh"
+
+class PARDCacheCP;
+
+/**
+ * Stride prefetcher obeying the per-DSid prefetch controls of the
+ * PARDCacheCP of its cache.
+ *
+ * The prefetches computed for a request are cut down to the degree
+ * the control plane allows for the DSid of that request. The owning
+ * PARDCache calls tagPending() once the request has been handled, so
+ * the prefetches it queued carry the same DSid down the hierarchy.
+ */
+class PARDStridePrefetcher : public StridePrefetcher
+{
+  public:
+    typedef PARDStridePrefetcherParams Params;
+    PARDStridePrefetcher(const Params *p);
+
+    void setControlPlane(PARDCacheCP *_cp) { cp = _cp; }
+
+    void calculatePrefetch(PacketPtr &pkt, std::list<Addr> &addresses,
+                           std::list<Cycles> &delays);
+
+    /**
+     * Attach DSid to the prefetches queued since the last call.
+     *
+     * @return number of prefetches tagged
+     */
+    unsigned tagPending(uint16_t DSid);
+
+  private:
+    PARDCacheCP *cp;
+};
+
+#endif	// __MEM_PARD_PREFETCHER_HH__
@@ -0,0 +1,72 @@
+#include <cassert>
+
+#include "base/misc.hh"
+#include "mem/pard_qos_queue.hh"
+
+DSidQoS::DSidQoS(const std::string &name, unsigned _limit,
+                 const std::vector<unsigned> &dsids,
+                 const std::vector<unsigned> &reserved,
+                 const std::vector<unsigned> &priority)
+    : limit(_limit), totalReserved(0), used(0), sharedUsed(0)
+{
+    fatal_if(dsids.size() != reserved.size() ||
+             dsids.size() != priority.size(),
+             "%s: qos_dsids, qos_reserved and qos_priority differ in "
+             "length\n", name);
+
+    for (size_t i = 0; i < dsids.size(); i++) {
+        Class &c = classes[dsids[i]];
+        c.reserved = reserved[i];
+        c.priority = priority[i];
+        c.used = 0;
+        totalReserved += reserved[i];
+    }
+
+    fatal_if(totalReserved > limit,
+             "%s: %d slots reserved out of %d\n", name, totalReserved,
+             limit);
+}
+
+unsigned
+DSidQoS::getPriority(uint16_t DSid) const
+{
+    auto c = classes.find(DSid);
+    return (c == classes.end()) ? 0 : c->second.priority;
+}
+
+bool
+DSidQoS::hasSpace(uint16_t DSid) const
+{
+    auto c = classes.find(DSid);
+    if (c != classes.end() && c->second.used < c->second.reserved)
+        return true;
+    return sharedUsed < limit - totalReserved;
+}
+
+void
+DSidQoS::take(uint16_t DSid)
+{
+    assert(hasSpace(DSid));
+
+    auto c = classes.find(DSid);
+    if (c == classes.end() || c->second.used >= c->second.reserved)
+        sharedUsed++;
+    if (c != classes.end())
+        c->second.used++;
+    used++;
+}
+
+void
+DSidQoS::give(uint16_t DSid)
+{
+    assert(used);
+
+    auto c = classes.find(DSid);
+    if (c != classes.end()) {
+        assert(c->second.used);
+        c->second.used--;
+    }
+    if (c == classes.end() || c->second.used >= c->second.reserved)
+        sharedUsed--;
+    used--;
+}
@@ -0,0 +1,187 @@
+#ifndef __MEM_PARD_QOS_QUEUE_HH__
+#define __MEM_PARD_QOS_QUEUE_HH__
+
+#include <algorithm>
+#include <cassert>
+#include <deque>
+#include <iterator>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "base/types.hh"
+#include "mem/packet.hh"
+
+/**
+ * Per-DSid slot accounting of a bounded queue.
+ *
+ * Each configured DSid has `reserved' slots nobody else may take, the
+ * remaining slots are shared by all DSids. A burst of one DSid thus
+ * never blocks the reservation of another one. Untagged (device or
+ * PIO) packets are accounted to the UntaggedDSid class, which can be
+ * given settings like any DSid.
+ */
+class DSidQoS
+{
+  public:
+
+    /**
+     * @param limit total number of slots
+     * @param dsids DSids with QoS settings
+     * @param reserved slots reserved for each of dsids
+     * @param priority service priority of each of dsids, higher first,
+     *        other DSids have priority 0
+     */
+    DSidQoS(const std::string &name, unsigned limit,
+            const std::vector<unsigned> &dsids,
+            const std::vector<unsigned> &reserved,
+            const std::vector<unsigned> &priority);
+
+    /** Class of untagged packets */
+    static const uint16_t UntaggedDSid = 0xFFFF;
+
+    /** Class pkt is accounted to */
+    static uint16_t classOf(PacketPtr pkt)
+    { return pkt->hasDSid() ? pkt->getDSid() : UntaggedDSid; }
+
+    unsigned getPriority(uint16_t DSid) const;
+
+    /** Is there a slot DSid may take */
+    bool hasSpace(uint16_t DSid) const;
+    bool full() const { return used == limit; }
+    unsigned occupied() const { return used; }
+
+    void take(uint16_t DSid);
+    void give(uint16_t DSid);
+
+  private:
+
+    struct Class {
+        unsigned reserved;
+        unsigned priority;
+        unsigned used;
+    };
+
+    const unsigned limit;
+    std::unordered_map<uint16_t, Class> classes;
+    unsigned totalReserved;
+
+    /** Slots taken, in total and out of the shared ones */
+    unsigned used;
+    unsigned sharedUsed;
+};
+
+/**
+ * Queue of deferred packets with one FIFO sub-queue per DSid.
+ *
+ * Among sub-queues with a head ready to go, the one of the highest
+ * priority is served first, the oldest head on a tie. Without QoS
+ * settings this is the plain FIFO order. T must have a `tick' member,
+ * the time it is ready to go.
+ */
+template <class T>
+class DSidQoSQueue
+{
+  public:
+
+    DSidQoSQueue(const DSidQoS &_qos) : qos(_qos), count(0), seq(0) { }
+
+    bool empty() const { return count == 0; }
+    size_t size() const { return count; }
+
+    void push(uint16_t DSid, const T &item)
+    {
+        queues[DSid].push_back(Entry(item, seq++));
+        count++;
+    }
+
+    /**
+     * Pick the sub-queue to serve at now, the queue must not be empty.
+     * If no head is ready yet, the earliest one is picked.
+     */
+    uint16_t select(Tick now) const
+    {
+        assert(!empty());
+
+        auto best = queues.begin();
+        for (auto i = std::next(best); i != queues.end(); ++i) {
+            if (before(*i, *best, now))
+                best = i;
+        }
+        return best->first;
+    }
+
+    /** Earliest tick any head is ready */
+    Tick nextTick() const
+    {
+        Tick next = MaxTick;
+        for (auto &q : queues)
+            next = std::min(next, q.second.front().item.tick);
+        return next;
+    }
+
+    T &front(uint16_t DSid)
+    { return queues.find(DSid)->second.front().item; }
+
+    void pop(uint16_t DSid)
+    {
+        auto i = queues.find(DSid);
+        assert(i != queues.end());
+        i->second.pop_front();
+        if (i->second.empty())
+            queues.erase(i);
+        count--;
+    }
+
+    /** Apply f to the queued items until it returns true */
+    template <class F>
+    bool find(F f) const
+    {
+        for (auto &q : queues) {
+            for (auto &e : q.second) {
+                if (f(e.item))
+                    return true;
+            }
+        }
+        return false;
+    }
+
+  private:
+
+    struct Entry {
+        T item;
+        uint64_t seq;
+        Entry(const T &_item, uint64_t _seq) : item(_item), seq(_seq) { }
+    };
+
+    typedef std::pair<const uint16_t, std::deque<Entry> > SubQueue;
+
+    /** Should sub-queue a be served before b at now */
+    bool before(const SubQueue &a, const SubQueue &b, Tick now) const
+    {
+        const Entry &ha = a.second.front();
+        const Entry &hb = b.second.front();
+        bool ready_a = ha.item.tick <= now;
+        bool ready_b = hb.item.tick <= now;
+
+        if (ready_a != ready_b)
+            return ready_a;
+        if (ready_a) {
+            unsigned prio_a = qos.getPriority(a.first);
+            unsigned prio_b = qos.getPriority(b.first);
+            if (prio_a != prio_b)
+                return prio_a > prio_b;
+        } else if (ha.item.tick != hb.item.tick) {
+            return ha.item.tick < hb.item.tick;
+        }
+        return ha.seq < hb.seq;
+    }
+
+    const DSidQoS &qos;
+    std::map<uint16_t, std::deque<Entry> > queues;
+    size_t count;
+    uint64_t seq;
+};
+
+#endif	// __MEM_PARD_QOS_QUEUE_HH__
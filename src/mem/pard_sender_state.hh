@@ -0,0 +1,134 @@
+#ifndef __MEM_PARD_SENDER_STATE_HH__
+#define __MEM_PARD_SENDER_STATE_HH__
+
+#include <cstdint>
+#include <vector>
+
+#include "base/misc.hh"
+#include "mem/packet.hh"
+
+/**
+ * Free-list allocator of per-packet sender states of one type.
+ *
+ * Storage is carved from arena chunks that are never returned to the
+ * host, freed states go back to the free list.
+ */
+template <class T>
+class SenderStatePool
+{
+  private:
+    static const int ChunkEntries = 1024;
+
+    /** Size of one slot, keeps every slot suitably aligned */
+    static const size_t SlotSize =
+        (sizeof(T) + sizeof(void *) - 1) / sizeof(void *) * sizeof(void *);
+
+    std::vector<void *> freeList;
+
+    SenderStatePool() { }
+
+    void grow()
+    {
+        char *chunk = new char[SlotSize * ChunkEntries];
+        for (int i = ChunkEntries - 1; i >= 0; i--)
+            freeList.push_back(chunk + i * SlotSize);
+    }
+
+  public:
+    static SenderStatePool &instance()
+    {
+        static SenderStatePool pool;
+        return pool;
+    }
+
+    void *allocate()
+    {
+        if (freeList.empty())
+            grow();
+        void *p = freeList.back();
+        freeList.pop_back();
+        return p;
+    }
+
+    void release(void *p)
+    {
+        freeList.push_back(p);
+    }
+};
+
+/**
+ * Common part of all pooled sender states, tagged with their type and
+ * the component pushing them.
+ */
+class PooledSenderStateBase : public Packet::SenderState
+{
+  public:
+    /** Identifies the type of the state, see PooledSenderState */
+    const void *const type;
+    /** Component that pushed this state */
+    const void *const owner;
+
+  protected:
+    PooledSenderStateBase(const void *_type, const void *_owner)
+        : type(_type), owner(_owner)
+    { }
+};
+
+/**
+ * Base of pooled sender states used by PARD pass-through components
+ * (PARDMemoryCtrl, TagAddrMapper, TagBridge, TagXBar, XBridge...).
+ *
+ * States are allocated from SenderStatePool<T>, and record their type
+ * and the component pushing them, so a component can find its own
+ * state on the top of a packet with two compares instead of
+ * dynamic_cast. The top state must be a pooled one, as it is for a
+ * response to a request the component forwarded:
+ *
+ *   class RequestState : public PooledSenderState<RequestState> { ... };
+ *
+ *   pkt->pushSenderState(new RequestState(this, ...));
+ *   ...
+ *   RequestState *state = RequestState::peek(pkt, this);
+ */
+template <class T>
+class PooledSenderState : public PooledSenderStateBase
+{
+  private:
+    /** Its address is the type tag of T */
+    static const char typeTag;
+
+  public:
+    PooledSenderState(const void *_owner)
+        : PooledSenderStateBase(&typeTag, _owner)
+    { }
+
+    static void *operator new(size_t size)
+    {
+        assert(size == sizeof(T));
+        return SenderStatePool<T>::instance().allocate();
+    }
+
+    static void operator delete(void *p)
+    {
+        SenderStatePool<T>::instance().release(p);
+    }
+
+    /**
+     * Get the top sender state of pkt if it is a T pushed by owner.
+     *
+     * @return the state, or NULL if the top state is not ours
+     */
+    static T *peek(PacketPtr pkt, const void *_owner)
+    {
+        PooledSenderStateBase *state =
+            static_cast<PooledSenderStateBase *>(pkt->senderState);
+        if (!state || state->type != &typeTag || state->owner != _owner)
+            return NULL;
+        return static_cast<T *>(state);
+    }
+};
+
+template <class T>
+const char PooledSenderState<T>::typeTag = 0;
+
+#endif	// __MEM_PARD_SENDER_STATE_HH__
@@ -33,9 +33,12 @@
  * Definition of coherent PARD system crossbar.
  */
 
+#include <algorithm>
+
 #include "base/misc.hh"
 #include "base/trace.hh"
 #include "debug/AddrRanges.hh"
+#include "debug/Drain.hh"
 #include "debug/PARDSystemXBar.hh"
 #include "mem/pard_system_xbar.hh"
 #include "sim/system.hh"
@@ -48,7 +51,20 @@ PARDSystemXBar::PARDSystemXBar(const PARDSystemXBarParams *p,
       memoryRanges(p->memory_ranges),
       ioPort(NULL),
       ioPortID(InvalidPortID),
-      ioRanges(p->io_ranges)
+      ioRanges(p->io_ranges),
+      cp(p->cp),
+      decodeCache(p->decode_cache_entries, p->decode_page_size),
+      dsidSnoopFilter(p->dsid_snoop_filter),
+      snoopSharedRanges(p->snoop_shared_ranges.begin(),
+                        p->snoop_shared_ranges.end()),
+      arbPolicy(p->arbitration),
+      memArbiter(p->default_weight),
+      memGrantPort(InvalidPortID),
+      memLayerRetryPort(InvalidPortID),
+      memPeerRetryPort(InvalidPortID),
+      memBusyUntil(0),
+      arbDrainManager(NULL),
+      arbEvent(this)
 {
     // create the slave ports, because they are faked in CoherentXBar
     // see PARDSystemXBarParams::create()
@@ -60,6 +76,8 @@ PARDSystemXBar::PARDSystemXBar(const PARDSystemXBarParams *p,
                                            csprintf(".respLayer%d", i)));
         snoopRespPorts.push_back(new SnoopRespPort(*bp, *this));
     }
+    lastOwnedDSid.resize(port_slave_connection_count, -1);
+    reqWaitSince.resize(port_slave_connection_count, MaxTick);
 
     // create memory port
     if (p->port_memory_port_connection_count) {
@@ -115,12 +133,257 @@ PARDSystemXBar::PARDSystemXBar(const PARDSystemXBarParams *p,
             }
         }
     }
+
+    cp->regPARDSystemXBar(this);
 }
 
 PARDSystemXBar::~PARDSystemXBar()
 {
 }
 
+void
+PARDSystemXBar::regStats()
+{
+    CoherentXBar::regStats();
+    decodeCache.regStats(name());
+
+    snoopsFiltered
+        .name(name() + ".snoops_filtered")
+        .desc("Number of snoops saved by DSid partitioning")
+        ;
+}
+
+void
+PARDSystemXBar::learnSnoopOwner(PacketPtr pkt, PortID slave_port_id)
+{
+    uint16_t DSid = pkt->getDSid();
+    if (!dsidSnoopFilter || lastOwnedDSid[slave_port_id] == DSid ||
+        !slavePorts[slave_port_id]->isSnooping())
+        return;
+
+    std::vector<bool> &owners = snoopOwners[DSid];
+    if (owners.empty())
+        owners.resize(slavePorts.size(), false);
+    if (!owners[slave_port_id])
+        DPRINTF(PARDSystemXBar, "%s owns lines of DSid#%d\n",
+                slavePorts[slave_port_id]->name(), DSid);
+    owners[slave_port_id] = true;
+    lastOwnedDSid[slave_port_id] = DSid;
+}
+
+bool
+PARDSystemXBar::partitionSnoops(PacketPtr pkt) const
+{
+    if (!dsidSnoopFilter)
+        return false;
+
+    for (const auto &r : snoopSharedRanges) {
+        if (r.contains(pkt->getAddr()))
+            return false;
+    }
+    return true;
+}
+
+std::vector<SlavePort*>
+PARDSystemXBar::snoopDests(PacketPtr pkt,
+                           const std::vector<SlavePort*> &dests)
+{
+    if (!partitionSnoops(pkt))
+        return dests;
+
+    std::vector<SlavePort*> owned;
+    auto i = snoopOwners.find(pkt->getDSid());
+    if (i != snoopOwners.end()) {
+        for (auto s : dests) {
+            if (i->second[s->getId()])
+                owned.push_back(s);
+        }
+    }
+    snoopsFiltered += dests.size() - owned.size();
+    return owned;
+}
+
+unsigned int
+PARDSystemXBar::drain(DrainManager *dm)
+{
+    unsigned int count = CoherentXBar::drain(dm);
+
+    if (!memArbiter.empty() || memGrantPort != InvalidPortID ||
+        memLayerRetryPort != InvalidPortID) {
+        DPRINTF(Drain, "%s: memory_port arbiter not drained\n", name());
+        arbDrainManager = dm;
+        count++;
+    }
+
+    return count;
+}
+
+void
+PARDSystemXBar::checkArbDrained()
+{
+    if (arbDrainManager && memArbiter.empty() &&
+        memGrantPort == InvalidPortID &&
+        memLayerRetryPort == InvalidPortID) {
+        arbDrainManager->signalDrainDone();
+        arbDrainManager = NULL;
+    }
+}
+
+void
+PARDSystemXBar::setArbPolicy(Enums::PARDXBarArb policy)
+{
+    DPRINTF(PARDSystemXBar, "arbitration policy: %s\n",
+            Enums::PARDXBarArbStrings[policy]);
+    // ports already held by the arbiter are still granted in order
+    arbPolicy = policy;
+}
+
+int
+PARDSystemXBar::trafficLink(PortID master_port_id) const
+{
+    if (master_port_id == memoryPortID)
+        return XBAR_LINK_MEM;
+    if (master_port_id == ioPortID)
+        return XBAR_LINK_IO;
+    return XBAR_LINK_OTHER;
+}
+
+void
+PARDSystemXBar::recordRefused(PacketPtr pkt, PortID slave_port_id,
+                              PortID master_port_id)
+{
+    if (reqWaitSince[slave_port_id] == MaxTick)
+        reqWaitSince[slave_port_id] = curTick();
+    cp->recordRetry(pkt->getDSid(), trafficLink(master_port_id));
+}
+
+void
+PARDSystemXBar::recordSent(uint16_t DSid, PortID slave_port_id,
+                           PortID master_port_id, unsigned int pkt_size)
+{
+    Tick queued = 0;
+    if (reqWaitSince[slave_port_id] != MaxTick) {
+        queued = curTick() - reqWaitSince[slave_port_id];
+        reqWaitSince[slave_port_id] = MaxTick;
+    }
+    cp->recordTraffic(DSid, trafficLink(master_port_id), pkt_size, queued);
+}
+
+bool
+PARDSystemXBar::admitMemReq(PacketPtr pkt, PortID slave_port_id)
+{
+    // ports we, or the layer, asked to try again go first
+    if (slave_port_id == memGrantPort) {
+        memGrantPort = InvalidPortID;
+        return true;
+    }
+    if (slave_port_id == memLayerRetryPort) {
+        memLayerRetryPort = InvalidPortID;
+        return true;
+    }
+    if (slave_port_id == memPeerRetryPort) {
+        memPeerRetryPort = InvalidPortID;
+        return true;
+    }
+
+    if (arbPolicy == Enums::pard_arb_fifo)
+        return true;
+
+    bool idle = memArbiter.empty() && curTick() >= memBusyUntil &&
+                memGrantPort == InvalidPortID &&
+                memLayerRetryPort == InvalidPortID &&
+                memPeerRetryPort == InvalidPortID;
+    if (idle)
+        return true;
+
+    uint16_t DSid = pkt->getDSid();
+    memArbiter.enqueue(DSid, slave_port_id);
+    cp->recordArbWait(DSid);
+    scheduleArbitration();
+    return false;
+}
+
+void
+PARDSystemXBar::clearMemRetry(PortID slave_port_id)
+{
+    if (slave_port_id != memLayerRetryPort &&
+        slave_port_id != memPeerRetryPort)
+        return;
+
+    DPRINTF(PARDSystemXBar, "%s no longer waits for memory_port\n",
+            slavePorts[slave_port_id]->name());
+    if (slave_port_id == memLayerRetryPort)
+        memLayerRetryPort = InvalidPortID;
+    if (slave_port_id == memPeerRetryPort)
+        memPeerRetryPort = InvalidPortID;
+    scheduleArbitration();
+    checkArbDrained();
+}
+
+void
+PARDSystemXBar::recvRetry(PortID master_port_id)
+{
+    CoherentXBar::recvRetry(master_port_id);
+
+    // the layer has retried the port, or will once it is free
+    if (master_port_id == memoryPortID &&
+        memPeerRetryPort != InvalidPortID) {
+        memLayerRetryPort = memPeerRetryPort;
+        memPeerRetryPort = InvalidPortID;
+        scheduleArbitration();
+    }
+}
+
+void
+PARDSystemXBar::scheduleArbitration()
+{
+    if ((!memArbiter.empty() || memLayerRetryPort != InvalidPortID) &&
+        !arbEvent.scheduled())
+        schedule(arbEvent, std::max(memBusyUntil, curTick()));
+}
+
+void
+PARDSystemXBar::processArbEvent()
+{
+    // the layer retries its port as it becomes free, a port still
+    // marked a cycle later did not come back to memory_port
+    if (memLayerRetryPort != InvalidPortID) {
+        if (curTick() <= memBusyUntil) {
+            schedule(arbEvent, memBusyUntil + clockPeriod());
+            return;
+        }
+        DPRINTF(PARDSystemXBar, "%s did not use its retry\n",
+                slavePorts[memLayerRetryPort]->name());
+        memLayerRetryPort = InvalidPortID;
+        checkArbDrained();
+    }
+
+    // wait for the port in flight, it reschedules us once it is done
+    if (memGrantPort != InvalidPortID ||
+        memPeerRetryPort != InvalidPortID || memArbiter.empty())
+        return;
+
+    if (curTick() < memBusyUntil) {
+        schedule(arbEvent, memBusyUntil);
+        return;
+    }
+
+    uint16_t DSid;
+    PortID port = memArbiter.grant(&DSid);
+    DPRINTF(PARDSystemXBar, "arbitration: grant %s DSid#%d\n",
+            slavePorts[port]->name(), DSid);
+
+    memGrantPort = port;
+    slavePorts[port]->sendRetry();
+
+    // the granted port did not try again, do not wait for it
+    if (memGrantPort == port) {
+        memGrantPort = InvalidPortID;
+        scheduleArbitration();
+        checkArbDrained();
+    }
+}
+
 AddrRangeList
 PARDSystemXBar::getAddrRanges() const
 {
@@ -132,6 +395,38 @@ PARDSystemXBar::getAddrRanges() const
     return ranges;
 }
 
+void
+PARDSystemXBar::recvRangeChange(PortID master_port_id)
+{
+    decodeCache.invalidate();
+    CoherentXBar::recvRangeChange(master_port_id);
+}
+
+PortID
+PARDSystemXBar::routeAddr(Addr addr)
+{
+    PortID port_id = decodeCache.lookup(addr);
+    if (port_id != InvalidPortID)
+        return port_id;
+
+    auto i = fixedPortMap.find(addr);
+    if (i != fixedPortMap.end()) {
+        decodeCache.insert(addr, i->first, i->second);
+        return i->second;
+    }
+
+    auto j = portMap.find(addr);
+    if (j != portMap.end()) {
+        // part of the page may still belong to memory or io port
+        if (fixedPortMap.find(decodeCache.pageOf(addr)) == fixedPortMap.end())
+            decodeCache.insert(addr, j->first, j->second);
+        return j->second;
+    }
+
+    // default port, or fatal
+    return findPort(addr);
+}
+
 BaseMasterPort &
 PARDSystemXBar::getMasterPort(const std::string &if_name, PortID idx)
 {
@@ -154,19 +449,32 @@ PARDSystemXBar::recvTimingReq(PacketPtr pkt, PortID slave_port_id)
     bool is_express_snoop = pkt->isExpressSnoop();
 
     // determine the destination based on the address
-    // check memory and io port first, then all master port
-    PortID master_port_id = InvalidPortID;
-    auto i = fixedPortMap.find(pkt->getAddr());
-    if (i != fixedPortMap.end())
-        master_port_id = i->second;
-    else
-        master_port_id = findPort(pkt->getAddr());
+    PortID master_port_id = routeAddr(pkt->getAddr());
+
+    // requests to memory are subject to DSid arbitration, inhibited
+    // packets should never be forced to retry
+    bool arbitrated = master_port_id == memoryPortID &&
+                      !is_express_snoop && !pkt->memInhibitAsserted();
+    uint16_t DSid = pkt->getDSid();
+    if (!arbitrated && !is_express_snoop)
+        clearMemRetry(slave_port_id);
+    if (arbitrated && !admitMemReq(pkt, slave_port_id)) {
+        DPRINTF(PARDSystemXBar, "recvTimingReq: src %s %s 0x%x HELD\n",
+                src_port->name(), pkt->cmdString(), pkt->getAddr());
+        recordRefused(pkt, slave_port_id, master_port_id);
+        return false;
+    }
 
     // test if the crossbar should be considered occupied for the current
     // port, and exclude express snoops from the check
     if (!is_express_snoop && !reqLayers[master_port_id]->tryTiming(src_port)) {
         DPRINTF(PARDSystemXBar, "recvTimingReq: src %s %s 0x%x BUSY\n",
                 src_port->name(), pkt->cmdString(), pkt->getAddr());
+        if (arbitrated && arbPolicy == Enums::pard_arb_drr) {
+            memLayerRetryPort = slave_port_id;
+            scheduleArbitration();
+        }
+        recordRefused(pkt, slave_port_id, master_port_id);
         return false;
     }
 
@@ -185,6 +493,9 @@ PARDSystemXBar::recvTimingReq(PacketPtr pkt, PortID slave_port_id)
     calcPacketTiming(pkt);
     Tick packetFinishTime = pkt->lastWordDelay + curTick();
 
+    if (!is_express_snoop)
+        learnSnoopOwner(pkt, slave_port_id);
+
     // uncacheable requests need never be snooped
     if (!pkt->req->isUncacheable() && !system->bypassCaches()) {
         // the packet is a memory-mapped request and should be
@@ -197,7 +508,9 @@ PARDSystemXBar::recvTimingReq(PacketPtr pkt, PortID slave_port_id)
                     " SF size: %i lat: %i\n", src_port->name(),
                     pkt->cmdString(), pkt->getAddr(), sf_res.first.size(),
                     sf_res.second);
-            forwardTiming(pkt, slave_port_id, sf_res.first);
+            forwardTiming(pkt, slave_port_id, snoopDests(pkt, sf_res.first));
+        } else if (partitionSnoops(pkt)) {
+            forwardTiming(pkt, slave_port_id, snoopDests(pkt, snoopPorts));
         } else {
             forwardTiming(pkt, slave_port_id);
         }
@@ -264,9 +577,25 @@ PARDSystemXBar::recvTimingReq(PacketPtr pkt, PortID slave_port_id)
             // update the layer state and schedule an idle event
             reqLayers[master_port_id]->failedTiming(src_port,
                                                     clockEdge(headerCycles));
+            if (master_port_id == memoryPortID)
+                memBusyUntil = std::max(memBusyUntil,
+                                        clockEdge(headerCycles));
+            if (arbitrated)
+                memPeerRetryPort = slave_port_id;
+            recordRefused(pkt, slave_port_id, master_port_id);
         } else {
             // update the layer state and schedule an idle event
             reqLayers[master_port_id]->succeededTiming(packetFinishTime);
+            recordSent(DSid, slave_port_id, master_port_id, pkt_size);
+            if (master_port_id == memoryPortID)
+                memBusyUntil = std::max(memBusyUntil, packetFinishTime);
+            if (arbitrated)
+                cp->recordArbGrant(DSid);
+        }
+
+        if (arbitrated) {
+            scheduleArbitration();
+            checkArbDrained();
         }
     }
 
@@ -307,7 +636,9 @@ PARDSystemXBar::recvTimingSnoopReq(PacketPtr pkt, PortID master_port_id)
                 sf_res.second);
 
         // forward to all snoopers
-        forwardTiming(pkt, InvalidPortID, sf_res.first);
+        forwardTiming(pkt, InvalidPortID, snoopDests(pkt, sf_res.first));
+    } else if (partitionSnoops(pkt)) {
+        forwardTiming(pkt, InvalidPortID, snoopDests(pkt, snoopPorts));
     } else {
         forwardTiming(pkt, InvalidPortID);
     }
@@ -335,6 +666,8 @@ PARDSystemXBar::recvAtomic(PacketPtr pkt, PortID slave_port_id)
     MemCmd snoop_response_cmd = MemCmd::InvalidCmd;
     Tick snoop_response_latency = 0;
 
+    learnSnoopOwner(pkt, slave_port_id);
+
     // uncacheable requests need never be snooped
     if (!pkt->req->isUncacheable() && !system->bypassCaches()) {
         // forward to all snoopers but the source
@@ -349,7 +682,10 @@ PARDSystemXBar::recvAtomic(PacketPtr pkt, PortID slave_port_id)
                     slavePorts[slave_port_id]->name(), pkt->cmdString(),
                     pkt->getAddr(), sf_res.first.size(), sf_res.second);
             snoop_result = forwardAtomic(pkt, slave_port_id, InvalidPortID,
-                                         sf_res.first);
+                                         snoopDests(pkt, sf_res.first));
+        } else if (partitionSnoops(pkt)) {
+            snoop_result = forwardAtomic(pkt, slave_port_id, InvalidPortID,
+                                         snoopDests(pkt, snoopPorts));
         } else {
             snoop_result = forwardAtomic(pkt, slave_port_id);
         }
@@ -359,18 +695,14 @@ PARDSystemXBar::recvAtomic(PacketPtr pkt, PortID slave_port_id)
 
     // even if we had a snoop response, we must continue and also
     // perform the actual request at the destination.
-    // check memory and io port first, then all master port
-    PortID master_port_id = InvalidPortID;
-    auto i = fixedPortMap.find(pkt->getAddr());
-    if (i != fixedPortMap.end())
-        master_port_id = i->second;
-    else
-        master_port_id = findPort(pkt->getAddr());
+    PortID master_port_id = routeAddr(pkt->getAddr());
 
     // stats updates for the request
     pktCount[slave_port_id][master_port_id]++;
     pktSize[slave_port_id][master_port_id] += pkt_size;
     transDist[pkt_cmd]++;
+    cp->recordTraffic(pkt->getDSid(), trafficLink(master_port_id),
+                      pkt_size, 0);
 
     // forward the request to the appropriate destination
     Tick response_latency = masterPorts[master_port_id]->sendAtomic(pkt);
@@ -416,7 +748,8 @@ PARDSystemXBar::recvFunctional(PacketPtr pkt, PortID slave_port_id)
                 pkt->cmdString());
     }
 
-    // uncacheable requests need never be snooped
+    // uncacheable requests need never be snooped, functional ones
+    // always go to all snoopers, as they may come from outside LDoms
     if (!pkt->req->isUncacheable() && !system->bypassCaches()) {
         // forward to all snoopers but the source
         forwardFunctional(pkt, slave_port_id);
@@ -425,13 +758,7 @@ PARDSystemXBar::recvFunctional(PacketPtr pkt, PortID slave_port_id)
     // there is no need to continue if the snooping has found what we
     // were looking for and the packet is already a response
     if (!pkt->isResponse()) {
-        // check memory and io port first, then all master port
-        PortID dest_id = InvalidPortID;
-        auto i = fixedPortMap.find(pkt->getAddr());
-        if (i != fixedPortMap.end())
-            dest_id = i->second;
-        else
-            dest_id = findPort(pkt->getAddr());
+        PortID dest_id = routeAddr(pkt->getAddr());
 
         masterPorts[dest_id]->sendFunctional(pkt);
     }
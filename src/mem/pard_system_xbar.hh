@@ -36,7 +36,13 @@
 #ifndef __MEM_PARD_SYSTEM_XBAR_HH__
 #define __MEM_PARD_SYSTEM_XBAR_HH__
 
+#include <unordered_map>
+
+#include "enums/PARDXBarArb.hh"
 #include "mem/coherent_xbar.hh"
+#include "mem/pard_decode_cache.hh"
+#include "mem/pard_dsid_arbiter.hh"
+#include "mem/pard_system_xbar_cp.hh"
 #include "params/PARDSystemXBar.hh"
 
 /**
@@ -124,10 +130,15 @@ class PARDSystemXBar : public CoherentXBar
         virtual void recvTimingSnoopReq(PacketPtr pkt)
         { return xbar.recvTimingSnoopReq(pkt, id); }
 
+        /** When receiving a retry from the peer, pass it to the crossbar. */
+        virtual void recvRetry()
+        { xbar.recvRetry(id); }
+
         /** When reciving a range change from the peer port, do nothing.
             Because we have fixed address range for this master port. */
         virtual void recvRangeChange() {
             // TODO: check if new range in fixed address range
+            xbar.decodeCache.invalidate();
         }
 
     };
@@ -146,6 +157,93 @@ class PARDSystemXBar : public CoherentXBar
     PortID ioPortID;
     std::vector<AddrRange> ioRanges;
 
+    PARDSystemXBarCP *cp;
+
+    /** Recently decoded pages, checked before fixedPortMap */
+    DecodeCache decodeCache;
+
+    /**
+     * Decide the destination port of addr: decode cache first, then
+     * memory and io port, then all master port.
+     */
+    PortID routeAddr(Addr addr);
+
+    /**
+     * DSid-partitioned snooping.
+     *
+     * LDoms share no cache lines, so a request only needs to snoop
+     * the caches which have ever issued requests of its DSid. Such
+     * owners are learned from the requests passing through the slave
+     * ports and never forgotten, as the cache may still hold lines of
+     * a DSid after its core is moved to another LDom. Requests to
+     * the shared ranges are snooped by everyone.
+     */
+    bool dsidSnoopFilter;
+    AddrRangeList snoopSharedRanges;
+    /** DSid ==> snooping slave ports owning it, by port id */
+    std::unordered_map<uint16_t, std::vector<bool> > snoopOwners;
+    /** DSid last learned on each slave port */
+    std::vector<int> lastOwnedDSid;
+
+    void learnSnoopOwner(PacketPtr pkt, PortID slave_port_id);
+    bool partitionSnoops(PacketPtr pkt) const;
+    /** Restrict dests to the snoop owners of the DSid of pkt */
+    std::vector<SlavePort*> snoopDests(PacketPtr pkt,
+                                       const std::vector<SlavePort*> &dests);
+
+    Stats::Scalar snoopsFiltered;
+
+    /**
+     * Per-DSid traffic accounting, kept in the control plane statistics
+     * table. A request waits from the first time its slave port is told
+     * to retry until it is sent.
+     */
+    std::vector<Tick> reqWaitSince;
+
+    int trafficLink(PortID master_port_id) const;
+    void recordRefused(PacketPtr pkt, PortID slave_port_id,
+                       PortID master_port_id);
+    void recordSent(uint16_t DSid, PortID slave_port_id,
+                    PortID master_port_id, unsigned int pkt_size);
+
+    /**
+     * DSid-weighted arbitration of the memory_port request layer.
+     *
+     * The request layer only keeps a FIFO of ports to retry. With
+     * pard_arb_drr, requests finding the layer occupied are held by
+     * DSidArbiter instead, and the next port is granted by deficit
+     * round-robin among DSids once the layer is free again, so the
+     * layer itself never has more than one port to retry.
+     */
+    Enums::PARDXBarArb arbPolicy;
+    DSidArbiter memArbiter;
+    /** Port granted by the arbiter */
+    PortID memGrantPort;
+    /**
+     * Port waiting in the retry list of the layer. The layer retries
+     * it once free, so it is forgotten after memBusyUntil even if it
+     * did not come back to memory_port.
+     */
+    PortID memLayerRetryPort;
+    /** Port waiting for a retry of memory_port peer */
+    PortID memPeerRetryPort;
+    /** Layer is occupied by the last request until this tick */
+    Tick memBusyUntil;
+
+    /** A port asked to retry is no longer waiting for memory_port */
+    void clearMemRetry(PortID slave_port_id);
+    void recvRetry(PortID master_port_id);
+
+    DrainManager *arbDrainManager;
+
+    /** Decide whether a memory_port request may try the layer now */
+    bool admitMemReq(PacketPtr pkt, PortID slave_port_id);
+    void scheduleArbitration();
+    void checkArbDrained();
+
+    void processArbEvent();
+    EventWrapper<PARDSystemXBar, &PARDSystemXBar::processArbEvent> arbEvent;
+
 
   protected:
 
@@ -173,6 +271,9 @@ class PARDSystemXBar : public CoherentXBar
      */
     AddrRangeList getAddrRanges() const;
 
+    /** Drop decoded pages before updating the port map. */
+    virtual void recvRangeChange(PortID master_port_id);
+
   public:
 
     /** A function used to return the port associated with this object. */
@@ -186,6 +287,23 @@ class PARDSystemXBar : public CoherentXBar
 
     virtual ~PARDSystemXBar();
 
+    unsigned int drain(DrainManager *dm);
+
+    virtual void regStats();
+
+    /**
+     * Arbitration interface, used by control plane, zero weight
+     * restores the default weight.
+     */
+    Enums::PARDXBarArb getArbPolicy() const { return arbPolicy; }
+    void setArbPolicy(Enums::PARDXBarArb policy);
+    unsigned getDefaultWeight() const
+    { return memArbiter.getDefaultWeight(); }
+    void setDefaultWeight(unsigned weight)
+    { memArbiter.setDefaultWeight(weight); }
+    void setWeight(uint16_t DSid, unsigned weight)
+    { memArbiter.setWeight(DSid, weight); }
+
 };
 
 #endif //__MEM_PARD_SYSTEM_XBAR_HH__
@@ -0,0 +1,255 @@
+#include <cstddef>
+
+#include "debug/ControlPlane.hh"
+#include "mem/pard_system_xbar.hh"
+#include "mem/pard_system_xbar_cp.hh"
+
+PARDSystemXBarCP::PARDSystemXBarCP(const Params *p)
+    : ControlPlane(p),
+      param_table_entries(p->param_table_entries),
+      stat_table_entries(p->stat_table_entries),
+      dsidIndex(p->param_table_entries),
+      xbar(NULL)
+{
+    panic_if(stat_table_entries < param_table_entries,
+             "%s: stat table (%d) smaller than param table (%d)\n",
+             name(), stat_table_entries, param_table_entries);
+
+    memset(&xbarInfo, 0, sizeof(xbarInfo));
+
+    // Allocate ConfigTable
+    paramTable = new struct XBarParamEntry[param_table_entries];
+    statTable  = new struct XBarStatEntry[stat_table_entries];
+    memset(paramTable, 0, sizeof(struct XBarParamEntry)*param_table_entries);
+    memset(statTable,  0, sizeof(struct XBarStatEntry) *stat_table_entries);
+}
+
+PARDSystemXBarCP::~PARDSystemXBarCP()
+{
+    delete[] paramTable;
+    delete[] statTable;
+}
+
+void
+PARDSystemXBarCP::regPARDSystemXBar(PARDSystemXBar *_xbar)
+{
+    panic_if(xbar, "%s already reg to %s\n",
+             name().c_str(), xbar->name().c_str());
+    xbar = _xbar;
+
+    xbarInfo.arb_policy = xbar->getArbPolicy();
+    xbarInfo.default_weight = xbar->getDefaultWeight();
+}
+
+int
+PARDSystemXBarCP::regTagLink(const std::string &xbar_name)
+{
+    fatal_if(xbarInfo.tag_links >= XBAR_NUM_TAG_LINKS,
+             "%s: too many tag crossbars, at most %d\n",
+             name(), XBAR_NUM_TAG_LINKS);
+
+    int link = XBAR_LINK_TAG + xbarInfo.tag_links++;
+    DPRINTF(ControlPlane, "%s: link %d is %s\n", name(), link, xbar_name);
+    return link;
+}
+
+int
+PARDSystemXBarCP::findTableRow(uint16_t DSid) const
+{
+    return dsidIndex.find(DSid);
+}
+
+XBarStatEntry *
+PARDSystemXBarCP::getStatEntry(uint16_t DSid)
+{
+    int row = findTableRow(DSid);
+    return (row < 0) ? NULL : &statTable[row];
+}
+
+void
+PARDSystemXBarCP::recordArbGrant(uint16_t DSid)
+{
+    XBarStatEntry *stat = getStatEntry(DSid);
+    if (stat)
+        stat->arbGrants++;
+}
+
+void
+PARDSystemXBarCP::recordArbWait(uint16_t DSid)
+{
+    XBarStatEntry *stat = getStatEntry(DSid);
+    if (stat)
+        stat->arbWaits++;
+}
+
+void
+PARDSystemXBarCP::recordTraffic(uint16_t DSid, int link, unsigned bytes,
+                                Tick queued)
+{
+    XBarStatEntry *stat = getStatEntry(DSid);
+    if (stat) {
+        stat->link[link].pkts++;
+        stat->link[link].bytes += bytes;
+        stat->link[link].queueDelay += queued;
+    }
+}
+
+void
+PARDSystemXBarCP::recordRetry(uint16_t DSid, int link)
+{
+    XBarStatEntry *stat = getStatEntry(DSid);
+    if (stat)
+        stat->link[link].retries++;
+}
+
+void
+PARDSystemXBarCP::paramUpdated(int row, const XBarParamEntry &old)
+{
+    XBarParamEntry &entry = paramTable[row];
+    bool was_valid = old.flags & XBAR_FLAG_VALID;
+    bool is_valid = entry.flags & XBAR_FLAG_VALID;
+
+    dsidIndex.set(row, is_valid ? entry.DSid : -1);
+
+    // (re)bind statistics row to this DSid
+    if (is_valid && (!was_valid || old.DSid != entry.DSid)) {
+        memset(&statTable[row], 0, sizeof(struct XBarStatEntry));
+        statTable[row].DSid = entry.DSid;
+        statTable[row].flags = XBAR_FLAG_VALID;
+    } else if (!is_valid) {
+        statTable[row].flags &= ~XBAR_FLAG_VALID;
+    }
+
+    if (!xbar)
+        return;
+
+    // withdraw or (re)program weight
+    if (was_valid && (!is_valid || old.DSid != entry.DSid))
+        xbar->setWeight(old.DSid, 0);
+    if (is_valid)
+        xbar->setWeight(entry.DSid, entry.weight);
+}
+
+void
+PARDSystemXBarCP::updateArbConfig(unsigned offset, uint64_t data)
+{
+    if (offset == offsetof(XBarInfo, arb_policy)) {
+        if (data >= Enums::Num_PARDXBarArb) {
+            warn("PARDSystemXBarCP: unknown arbitration policy %d", data);
+            return;
+        }
+        xbarInfo.arb_policy = data;
+        if (xbar)
+            xbar->setArbPolicy((Enums::PARDXBarArb)data);
+    } else if (offset == offsetof(XBarInfo, default_weight)) {
+        if (data == 0) {
+            warn("PARDSystemXBarCP: default_weight must be non-zero");
+            return;
+        }
+        xbarInfo.default_weight = data;
+        if (xbar)
+            xbar->setDefaultWeight(data);
+    } else {
+        warn("PARDSystemXBarCP: sysinfo offset 0x%x is read-only", offset);
+    }
+}
+
+uint64_t *
+PARDSystemXBarCP::parseAddr(uint32_t addr)
+{
+    char *ptr = NULL;
+    int offset;
+
+    switch (addr & ADDRTYPE_MASK)
+    {
+      case ADDRTYPE_CFGTBL:
+        {
+            int row = cfgtbl_addr2row(addr);
+            offset = cfgtbl_addr2offset(addr);
+
+            switch (cfgtbl_addr2type(addr)) {
+              case CFGTBL_TYPE_PARAM:
+                if ((row < param_table_entries) &&
+                    (offset <= sizeof(struct XBarParamEntry) - sizeof(uint64_t)))
+                    ptr = (char *)&paramTable[row];
+                break;
+              case CFGTBL_TYPE_STAT:
+                if ((row < stat_table_entries) &&
+                    (offset <= sizeof(struct XBarStatEntry) - sizeof(uint64_t)))
+                    ptr = (char *)&statTable[row];
+                break;
+            }
+        }
+        break;
+      case ADDRTYPE_SYSINFO:
+        offset = sysinfo_addr2offset(addr);
+        if (offset <= sizeof(xbarInfo) - sizeof(uint64_t))
+            ptr = (char *)&xbarInfo;
+        break;
+    }
+
+    return (ptr ? ((uint64_t *)(ptr + offset)) : NULL);
+}
+
+uint64_t
+PARDSystemXBarCP::queryTable(uint16_t DSid, uint32_t addr)
+{
+    uint64_t *pdata;
+
+    DPRINTF(ControlPlane, "queryTable(DSid=%d, addr=0x%x)\n",
+            DSid, addr);
+
+    if (isTriggerAddr(addr))
+        return queryTrigger(addr);
+
+    pdata = parseAddr(addr);
+    if (!pdata) {
+        warn("PARDSystemXBarCP: unknown addr 0x%x", addr);
+        return 0xFFFFFFFFFFFFFFFF;
+    }
+
+    return *pdata;
+}
+
+void
+PARDSystemXBarCP::updateTable(uint16_t DSid, uint32_t addr, uint64_t data)
+{
+    uint64_t *pdata;
+
+    DPRINTF(ControlPlane, "updateTable(DSid=%d, addr=0x%x, data=0x%x)\n",
+            DSid, addr, data);
+
+    if (isTriggerAddr(addr)) {
+        updateTrigger(addr, data);
+        return;
+    }
+
+    pdata = parseAddr(addr);
+    if (!pdata) {
+        warn("PARDSystemXBarCP: unknown addr 0x%x", addr);
+        return;
+    }
+
+    if ((addr & ADDRTYPE_MASK) == ADDRTYPE_SYSINFO) {
+        updateArbConfig(sysinfo_addr2offset(addr), data);
+        return;
+    }
+
+    // only parameter table is writable
+    if ((addr & ADDRTYPE_MASK) != ADDRTYPE_CFGTBL ||
+        cfgtbl_addr2type(addr) != CFGTBL_TYPE_PARAM) {
+        warn("PARDSystemXBarCP: addr 0x%x is read-only", addr);
+        return;
+    }
+
+    int row = cfgtbl_addr2row(addr);
+    XBarParamEntry old = paramTable[row];
+    *pdata = data;
+    paramUpdated(row, old);
+}
+
+PARDSystemXBarCP *
+PARDSystemXBarCPParams::create()
+{
+    return new PARDSystemXBarCP(this);
+}
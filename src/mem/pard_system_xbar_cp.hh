@@ -0,0 +1,122 @@
+/**
+ * PARDg5-V System Crossbar Control Plane
+ *
+ * Uses the same ConfigTable/SystemInfo address mapping as
+ * PARDg5VSystemCP (see arch/x86/pardg5v_system_cp.hh). Row #i of the
+ * statistics table holds the counters of the DSid in row #i of the
+ * parameter table; it is reset when the parameter row becomes valid.
+ *
+ * weight is the share of the DSid in the memory_port request layer
+ * under the pard_arb_drr arbitration, 0 means the default weight.
+ * The arbitration fields of SystemInfo are writable.
+ *
+ * The statistics row also holds the traffic of the DSid on each link:
+ * memory_port, io_port, other master ports of the crossbar, and each
+ * TagXBar/CoherentTagXBar reporting to this control plane, which gets
+ * link XBAR_LINK_TAG + i in the order they are created (tag_links in
+ * SystemInfo). Queueing delay is the time in ticks requests waited
+ * for a retry.
+ */
+
+#ifndef __MEM_PARD_SYSTEM_XBAR_CP_HH__
+#define __MEM_PARD_SYSTEM_XBAR_CP_HH__
+
+#include "params/PARDSystemXBarCP.hh"
+#include "prm/ControlPlane.hh"
+#include "prm/DSidIndex.hh"
+
+#define XBAR_FLAG_VALID		0x8000
+
+#define XBAR_LINK_MEM		0
+#define XBAR_LINK_IO		1
+#define XBAR_LINK_OTHER		2
+#define XBAR_LINK_TAG		3
+#define XBAR_NUM_TAG_LINKS	16
+#define XBAR_NUM_LINKS		(XBAR_LINK_TAG + XBAR_NUM_TAG_LINKS)
+
+struct XBarParamEntry {
+    uint16_t DSid;
+    uint16_t flags;
+    uint32_t __padding;
+    uint64_t weight;
+};
+
+struct XBarLinkStat {
+    uint64_t pkts;
+    uint64_t bytes;
+    uint64_t queueDelay;
+    uint64_t retries;
+};
+
+struct XBarStatEntry {
+    uint16_t DSid;
+    uint16_t flags;
+    uint32_t __padding;
+    // requests passed / held by the memory_port arbiter
+    uint64_t arbGrants;
+    uint64_t arbWaits;
+    struct XBarLinkStat link[XBAR_NUM_LINKS];
+};
+
+struct XBarInfo {
+    uint64_t arb_policy;        // Enums::PARDXBarArb, writable
+    uint64_t default_weight;    // writable
+    uint64_t tag_links;
+};
+
+class PARDSystemXBar;
+
+class PARDSystemXBarCP : public ControlPlane
+{
+  protected:
+    int param_table_entries;
+    int stat_table_entries;
+
+    struct XBarParamEntry *paramTable;
+    struct XBarStatEntry  *statTable;
+    struct XBarInfo xbarInfo;
+    DSidIndex dsidIndex;
+
+    PARDSystemXBar *xbar;
+
+  public:
+    typedef PARDSystemXBarCPParams Params;
+    PARDSystemXBarCP(const Params *p);
+    ~PARDSystemXBarCP();
+
+    void regPARDSystemXBar(PARDSystemXBar *_xbar);
+
+  public:
+    XBarStatEntry *getStatEntry(uint16_t DSid);
+
+    /**
+     * Statistics interface, called by PARDSystemXBar.
+     */
+    void recordArbGrant(uint16_t DSid);
+    void recordArbWait(uint16_t DSid);
+    void recordTraffic(uint16_t DSid, int link, unsigned bytes, Tick queued);
+    void recordRetry(uint16_t DSid, int link);
+
+    /** Assign a link to a tag crossbar accounting to this control plane */
+    int regTagLink(const std::string &xbar_name);
+
+    virtual uint64_t queryTable(uint16_t DSid, uint32_t addr);
+    virtual void updateTable(uint16_t DSid, uint32_t addr, uint64_t data);
+
+  protected:
+    virtual int findTableRow(uint16_t DSid) const;
+    virtual size_t statEntrySize() const
+    { return sizeof(struct XBarStatEntry); }
+    virtual int statTableEntries() const { return stat_table_entries; }
+
+  private:
+    uint64_t *parseAddr(uint32_t addr);
+    void paramUpdated(int row, const XBarParamEntry &old);
+    void updateArbConfig(unsigned offset, uint64_t data);
+
+  protected:
+    const Params *param() const
+    { return dynamic_cast<const Params *>(_params); }
+};
+
+#endif	// __MEM_PARD_SYSTEM_XBAR_CP_HH__
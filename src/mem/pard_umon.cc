@@ -0,0 +1,108 @@
+#include <algorithm>
+#include <cassert>
+
+#include "mem/pard_umon.hh"
+
+UtilityMonitor::UtilityMonitor(unsigned _assoc, unsigned sample_interval)
+    : assoc(_assoc), interval(sample_interval ? sample_interval : 1)
+{
+}
+
+void
+UtilityMonitor::access(uint16_t DSid, int set, Addr tag)
+{
+    assert(sampled(set));
+
+    Shadow &shadow = shadows[DSid];
+    if (shadow.hits.empty())
+        shadow.hits.resize(assoc, 0);
+
+    std::vector<Addr> &stack = shadow.sets[set];
+    auto it = std::find(stack.begin(), stack.end(), tag);
+    if (it != stack.end()) {
+        shadow.hits[it - stack.begin()]++;
+        stack.erase(it);
+    } else {
+        shadow.misses++;
+        if (stack.size() == assoc)
+            stack.pop_back();
+    }
+    stack.insert(stack.begin(), tag);
+}
+
+uint64_t
+UtilityMonitor::utility(const Demand &demand, unsigned from,
+                        unsigned to) const
+{
+    auto it = shadows.find(demand.DSid);
+    if (it == shadows.end())
+        return 0;
+
+    uint64_t hits = 0;
+    for (unsigned i = from; i < to; i++)
+        hits += it->second.hits[i];
+    return hits * demand.weight;
+}
+
+std::vector<unsigned>
+UtilityMonitor::partition(const std::vector<Demand> &demands) const
+{
+    assert(demands.size() <= assoc);
+
+    std::vector<unsigned> alloc(demands.size());
+    unsigned balance = assoc;
+    if (demands.empty())
+        return alloc;
+
+    // minimum guarantees are served in order while ways last
+    for (size_t i = 0; i < demands.size(); i++) {
+        unsigned ways = std::max(demands[i].minWays, 1U);
+        // leave one way to each of the following demands
+        ways = std::min(ways, balance - (unsigned)(demands.size() - i - 1));
+        alloc[i] = ways;
+        balance -= ways;
+    }
+
+    while (balance) {
+        size_t best = demands.size();
+        unsigned best_ways = 0;
+        uint64_t best_util = 0;
+
+        // compare utility per way, u/k > best_u/best_k
+        for (size_t i = 0; i < demands.size(); i++) {
+            for (unsigned k = 1; k <= balance; k++) {
+                uint64_t u = utility(demands[i], alloc[i], alloc[i] + k);
+                if (u * best_ways > best_util * k ||
+                    (best == demands.size() && u)) {
+                    best = i;
+                    best_ways = k;
+                    best_util = u;
+                }
+            }
+        }
+
+        if (best == demands.size()) {
+            // nobody gains from more ways, spread the rest evenly
+            for (size_t i = 0; balance; i = (i + 1) % demands.size()) {
+                alloc[i]++;
+                balance--;
+            }
+            break;
+        }
+
+        alloc[best] += best_ways;
+        balance -= best_ways;
+    }
+
+    return alloc;
+}
+
+void
+UtilityMonitor::decay()
+{
+    for (auto &s : shadows) {
+        for (auto &h : s.second.hits)
+            h /= 2;
+        s.second.misses /= 2;
+    }
+}
@@ -0,0 +1,69 @@
+#ifndef __MEM_PARD_UMON_HH__
+#define __MEM_PARD_UMON_HH__
+
+#include <unordered_map>
+#include <vector>
+
+#include "base/types.hh"
+
+/**
+ * Utility monitor (UMON) of a set-associative cache.
+ *
+ * Each DSid has an auxiliary tag directory over one out of every
+ * `sample_interval' sets, kept in true LRU order as if the DSid owned
+ * the whole cache. A hit at stack position p would be a hit with any
+ * allocation larger than p ways, so the hit counters give the miss
+ * curve of the DSid over 1..assoc ways.
+ */
+class UtilityMonitor
+{
+  public:
+
+    struct Demand {
+        uint16_t DSid;
+        unsigned minWays;
+        unsigned weight;
+    };
+
+    UtilityMonitor(unsigned assoc, unsigned sample_interval);
+
+    bool sampled(int set) const { return set % interval == 0; }
+
+    /** Account an access of DSid to tag in a sampled set */
+    void access(uint16_t DSid, int set, Addr tag);
+
+    /**
+     * Lookahead partitioning: starting from the minimum of each
+     * demand (at least one way), hand out the remaining ways to the
+     * DSid with the highest weighted hits per extra way.
+     *
+     * @param demands DSids to partition among, at most assoc of them
+     * @return number of ways of each demand, in order
+     */
+    std::vector<unsigned> partition(const std::vector<Demand> &demands) const;
+
+    /** Halve all hit counters so that old phases fade out */
+    void decay();
+
+  private:
+
+    struct Shadow {
+        // sampled set -> tags, MRU first
+        std::unordered_map<int, std::vector<Addr> > sets;
+        // hits at each LRU stack position
+        std::vector<uint64_t> hits;
+        uint64_t misses;
+        Shadow() : misses(0) { }
+    };
+
+    /** Weighted hits of DSid given ways in [from, to) */
+    uint64_t utility(const Demand &demand, unsigned from,
+                     unsigned to) const;
+
+    const unsigned assoc;
+    const unsigned interval;
+
+    std::unordered_map<uint16_t, Shadow> shadows;
+};
+
+#endif	// __MEM_PARD_UMON_HH__
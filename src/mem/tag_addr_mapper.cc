@@ -44,7 +44,9 @@
 TagAddrMapper::TagAddrMapper(const TagAddrMapperParams* p)
     : MemObject(p),
       masterPort(name() + "-master", *this),
-      slavePort(name() + "-slave", *this)
+      slavePort(name() + "-slave", *this),
+      faultRetry(false), respRetry(false),
+      faultEvent(this), drainManager(NULL)
 {
 }
 
@@ -55,6 +57,19 @@ TagAddrMapper::init()
         fatal("Address mapper is not connected on both sides.\n");
 }
 
+unsigned int
+TagAddrMapper::drain(DrainManager *dm)
+{
+    if (faultQueue.empty()) {
+        setDrainState(Drainable::Drained);
+        return 0;
+    }
+
+    drainManager = dm;
+    setDrainState(Drainable::Draining);
+    return 1;
+}
+
 BaseMasterPort&
 TagAddrMapper::getMasterPort(const std::string& if_name, PortID idx)
 {
@@ -79,7 +94,18 @@ void
 TagAddrMapper::recvFunctional(PacketPtr pkt)
 {
     Addr orig_addr = pkt->getAddr();
-    pkt->setAddr(remapAddr(orig_addr, pkt->getDSid()));
+    Addr remapped;
+    if (!translate(orig_addr, pkt->getDSid(), remapped)) {
+        warn("%s: DSid#%d functional access to unmapped 0x%x\n",
+             name(), pkt->getDSid(), orig_addr);
+        if (pkt->needsResponse()) {
+            pkt->makeResponse();
+            pkt->setBadAddress();
+        }
+        return;
+    }
+
+    pkt->setAddr(remapped);
     preReqHook(pkt);
     masterPort.sendFunctional(pkt);
     postRespHook(pkt);
@@ -89,8 +115,13 @@ TagAddrMapper::recvFunctional(PacketPtr pkt)
 void
 TagAddrMapper::recvFunctionalSnoop(PacketPtr pkt)
 {
+    // nobody above can hold a line of an unmapped address
     Addr orig_addr = pkt->getAddr();
-    pkt->setAddr(remapAddr(orig_addr, pkt->getDSid()));
+    Addr remapped;
+    if (!translate(orig_addr, pkt->getDSid(), remapped))
+        return;
+
+    pkt->setAddr(remapped);
     slavePort.sendFunctionalSnoop(pkt);
     pkt->setAddr(orig_addr);
 }
@@ -99,7 +130,18 @@ Tick
 TagAddrMapper::recvAtomic(PacketPtr pkt)
 {
     Addr orig_addr = pkt->getAddr();
-    pkt->setAddr(remapAddr(orig_addr, pkt->getDSid()));
+    Addr remapped;
+    if (!translate(orig_addr, pkt->getDSid(), remapped)) {
+        warn("%s: DSid#%d access to unmapped 0x%x\n",
+             name(), pkt->getDSid(), orig_addr);
+        if (pkt->needsResponse()) {
+            pkt->makeAtomicResponse();
+            pkt->setBadAddress();
+        }
+        return 0;
+    }
+
+    pkt->setAddr(remapped);
     preReqHook(pkt);
     Tick ret_tick =  masterPort.sendAtomic(pkt);
     postRespHook(pkt);
@@ -111,7 +153,11 @@ Tick
 TagAddrMapper::recvAtomicSnoop(PacketPtr pkt)
 {
     Addr orig_addr = pkt->getAddr();
-    pkt->setAddr(remapAddr(orig_addr, pkt->getDSid()));
+    Addr remapped;
+    if (!translate(orig_addr, pkt->getDSid(), remapped))
+        return 0;
+
+    pkt->setAddr(remapped);
     Tick ret_tick = slavePort.sendAtomicSnoop(pkt);
     pkt->setAddr(orig_addr);
     return ret_tick;
@@ -124,11 +170,17 @@ TagAddrMapper::recvTimingReq(PacketPtr pkt)
     bool needsResponse = pkt->needsResponse();
     bool memInhibitAsserted = pkt->memInhibitAsserted();
 
+    Addr remapped;
+    if (!translate(orig_addr, pkt->getDSid(), remapped)) {
+        faultTimingReq(pkt);
+        return true;
+    }
+
     if (needsResponse && !memInhibitAsserted) {
-        pkt->pushSenderState(new TagAddrMapperSenderState(orig_addr));
+        pkt->pushSenderState(new TagAddrMapperSenderState(this, orig_addr));
     }
 
-    pkt->setAddr(remapAddr(orig_addr, pkt->getDSid()));
+    pkt->setAddr(remapped);
     preReqHook(pkt);
 
     // Attempt to send the packet (always succeeds for inhibited
@@ -147,7 +199,7 @@ bool
 TagAddrMapper::recvTimingResp(PacketPtr pkt)
 {
     TagAddrMapperSenderState* receivedState =
-        dynamic_cast<TagAddrMapperSenderState*>(pkt->senderState);
+        TagAddrMapperSenderState::peek(pkt, this);
 
     // Restore initial sender state
     if (receivedState == NULL)
@@ -174,6 +226,7 @@ TagAddrMapper::recvTimingResp(PacketPtr pkt)
         // not touch it
         pkt->senderState = receivedState;
         pkt->setAddr(remapped_addr);
+        respRetry = true;
     }
     return successful;
 }
@@ -207,7 +260,56 @@ TagAddrMapper::recvRetryMaster()
 void
 TagAddrMapper::recvRetrySlave()
 {
-    masterPort.sendRetry();
+    if (faultRetry) {
+        faultRetry = false;
+        sendFaults();
+        if (faultRetry)
+            return;
+    }
+    if (respRetry) {
+        respRetry = false;
+        masterPort.sendRetry();
+    }
+}
+
+void
+TagAddrMapper::faultTimingReq(PacketPtr pkt)
+{
+    warn("%s: DSid#%d access to unmapped 0x%x\n",
+         name(), pkt->getDSid(), pkt->getAddr());
+
+    // inhibited requests are answered by their owner, and requests
+    // without response are dropped once the sender is done with them
+    if (pkt->needsResponse() && !pkt->memInhibitAsserted()) {
+        pkt->makeTimingResponse();
+        pkt->setBadAddress();
+    }
+    faultQueue.push_back(pkt);
+    if (!faultEvent.scheduled() && !faultRetry)
+        schedule(faultEvent, curTick());
+}
+
+void
+TagAddrMapper::sendFaults()
+{
+    while (!faultQueue.empty()) {
+        PacketPtr pkt = faultQueue.front();
+        if (pkt->isResponse()) {
+            if (!slavePort.sendTimingResp(pkt)) {
+                faultRetry = true;
+                return;
+            }
+        } else {
+            delete pkt;
+        }
+        faultQueue.pop_front();
+    }
+
+    if (drainManager) {
+        setDrainState(Drainable::Drained);
+        drainManager->signalDrainDone();
+        drainManager = NULL;
+    }
 }
 
 void
@@ -42,7 +42,10 @@
 #ifndef __MEM_TAG_ADDR_MAPPER_HH__
 #define __MEM_TAG_ADDR_MAPPER_HH__
 
+#include <deque>
+
 #include "mem/mem_object.hh"
+#include "mem/pard_sender_state.hh"
 #include "params/TagAddrMapper.hh"
 
 /**
@@ -76,6 +79,8 @@ class TagAddrMapper : public MemObject
 
     virtual void init();
 
+    unsigned int drain(DrainManager *dm);
+
   protected:
 
     /**
@@ -87,10 +92,36 @@ class TagAddrMapper : public MemObject
      */
     virtual Addr remapAddr(Addr addr, uint16_t DSid) const = 0;
 
+    /**
+     * Translate addr of DSid, false if it has no translation. Such
+     * accesses are not forwarded but answered with a BadAddress error,
+     * and such snoops are not forwarded at all.
+     */
+    virtual bool translate(Addr addr, uint16_t DSid, Addr &remapped) const
+    {
+        remapped = remapAddr(addr, DSid);
+        return true;
+    }
+
+    /** Answer a timing request without translation */
+    void faultTimingReq(PacketPtr pkt);
+    void sendFaults();
+
+    /** Error responses, and requests to drop, of faulting requests */
+    std::deque<PacketPtr> faultQueue;
+    /** Upstream refused a fault response, or a forwarded response */
+    bool faultRetry;
+    bool respRetry;
+
+    EventWrapper<TagAddrMapper, &TagAddrMapper::sendFaults> faultEvent;
+
+    DrainManager *drainManager;
+
     virtual void preReqHook(PacketPtr pkt) {}
     virtual void postRespHook(PacketPtr pkt) {}
 
-    class TagAddrMapperSenderState : public Packet::SenderState
+    class TagAddrMapperSenderState
+        : public PooledSenderState<TagAddrMapperSenderState>
     {
 
       public:
@@ -98,9 +129,12 @@ class TagAddrMapper : public MemObject
         /**
          * Construct a new sender state to remember the original address.
          *
+         * @param _owner Mapper pushing this state
          * @param _origAddr Address before remapping
          */
-        TagAddrMapperSenderState(Addr _origAddr) : origAddr(_origAddr)
+        TagAddrMapperSenderState(const TagAddrMapper *_owner, Addr _origAddr)
+            : PooledSenderState<TagAddrMapperSenderState>(_owner),
+              origAddr(_origAddr)
         { }
 
         /** Destructor */
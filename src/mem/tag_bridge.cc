@@ -60,8 +60,10 @@ TagBridge::BridgeSlavePort::BridgeSlavePort(const std::string& _name,
                                          std::vector<AddrRange> _ranges)
     : SlavePort(_name, &_bridge), bridge(_bridge), masterPort(_masterPort),
       delay(_delay), ranges(_ranges.begin(), _ranges.end()),
-      outstandingResponses(0), retryReq(false),
-      respQueueLimit(_resp_limit), sendEvent(*this)
+      qos(_name, _resp_limit, _bridge.params()->qos_dsids,
+          _bridge.params()->qos_reserved, _bridge.params()->qos_priority),
+      transmitList(qos), retryReq(false), retryDSid(0),
+      retryExpectsResp(false), sendEvent(*this)
 {
 }
 
@@ -70,7 +72,10 @@ TagBridge::BridgeMasterPort::BridgeMasterPort(const std::string& _name,
                                            BridgeSlavePort& _slavePort,
                                            Cycles _delay, int _req_limit)
     : MasterPort(_name, &_bridge), bridge(_bridge), slavePort(_slavePort),
-      delay(_delay), reqQueueLimit(_req_limit), sendEvent(*this)
+      delay(_delay),
+      qos(_name, _req_limit, _bridge.params()->qos_dsids,
+          _bridge.params()->qos_reserved, _bridge.params()->qos_priority),
+      transmitList(qos), sendEvent(*this)
 {
 }
 
@@ -81,7 +86,8 @@ TagBridge::TagBridge(Params *p)
       masterPort(p->name + ".master", *this, slavePort,
                  ticksToCycles(p->delay), p->req_size),
       DSid(p->DSid),
-      DSid_base_addr(p->DSid_base_addr)
+      DSid_base_addr(p->DSid_base_addr),
+      classifier(p->name, p->DSid, p->DSid_ranges, p->DSid_range_map)
 {
 }
 
@@ -117,15 +123,21 @@ TagBridge::init()
 }
 
 bool
-TagBridge::BridgeSlavePort::respQueueFull() const
+TagBridge::BridgeSlavePort::respQueueFull(uint16_t DSid) const
 {
-    return outstandingResponses == respQueueLimit;
+    return !qos.hasSpace(DSid);
 }
 
 bool
 TagBridge::BridgeMasterPort::reqQueueFull() const
 {
-    return transmitList.size() == reqQueueLimit;
+    return qos.full();
+}
+
+bool
+TagBridge::BridgeMasterPort::reqQueueFull(uint16_t DSid) const
+{
+    return !qos.hasSpace(DSid);
 }
 
 bool
@@ -155,11 +167,16 @@ TagBridge::BridgeSlavePort::recvTimingReq(PacketPtr pkt)
     // we should not see a timing request if we are already in a retry
     assert(!retryReq);
 
+    // classify the request, the DSid is only attached once the
+    // request is accepted
+    assert(!pkt->hasDSid());
+    uint16_t DSid = bridge.classifier.classify(pkt->getAddr());
+
     DPRINTF(TagBridge, "Response queue size: %d outresp: %d\n",
-            transmitList.size(), outstandingResponses);
+            transmitList.size(), qos.occupied());
 
     // if the request queue is full then there is no hope
-    if (masterPort.reqQueueFull()) {
+    if (masterPort.reqQueueFull(DSid)) {
         DPRINTF(TagBridge, "Request queue full\n");
         retryReq = true;
     } else {
@@ -167,25 +184,23 @@ TagBridge::BridgeSlavePort::recvTimingReq(PacketPtr pkt)
         bool expects_response = pkt->needsResponse() &&
             !pkt->memInhibitAsserted();
         if (expects_response) {
-            if (respQueueFull()) {
+            if (respQueueFull(DSid)) {
                 DPRINTF(TagBridge, "Response queue full\n");
                 retryReq = true;
             } else {
                 // ok to send the request with space for the response
                 DPRINTF(TagBridge, "Reserving space for response\n");
-                assert(outstandingResponses != respQueueLimit);
-                ++outstandingResponses;
+                qos.take(DSid);
 
                 // no need to set retryReq to false as this is already the
                 // case
             }
         }
 
-        // attach DSid to pkt
-        assert(!pkt->hasDSid());
-        pkt->setDSid(bridge.DSid);
-
         if (!retryReq) {
+            // attach DSid to pkt
+            pkt->setDSid(DSid);
+
             // @todo: We need to pay for this and not just zero it out
             pkt->firstWordDelay = pkt->lastWordDelay = 0;
 
@@ -193,6 +208,11 @@ TagBridge::BridgeSlavePort::recvTimingReq(PacketPtr pkt)
         }
     }
 
+    if (retryReq) {
+        retryDSid = DSid;
+        retryExpectsResp = pkt->needsResponse() && !pkt->memInhibitAsserted();
+    }
+
     // remember that we are now stalling a packet and that we have to
     // tell the sending master to retry once space becomes available,
     // we make no distinction whether the stalling is due to the
@@ -203,7 +223,9 @@ TagBridge::BridgeSlavePort::recvTimingReq(PacketPtr pkt)
 void
 TagBridge::BridgeSlavePort::retryStalledReq()
 {
-    if (retryReq) {
+    // the freed slot may not be usable by the DSid of the request
+    if (retryReq && !masterPort.reqQueueFull(retryDSid) &&
+        !(retryExpectsResp && respQueueFull(retryDSid))) {
         DPRINTF(TagBridge, "Request waiting for retry, now retrying\n");
         retryReq = false;
         sendRetry();
@@ -219,7 +241,7 @@ TagBridge::BridgeMasterPort::schedTimingReq(PacketPtr pkt, Tick when)
     if (!pkt->memInhibitAsserted() && pkt->needsResponse()) {
         // Update the sender state so we can deal with the response
         // appropriately
-        pkt->pushSenderState(new RequestState(pkt->getSrc()));
+        pkt->pushSenderState(new RequestState(&bridge, pkt->getSrc()));
     }
 
     // If we're about to put this packet at the head of the queue, we
@@ -230,9 +252,9 @@ TagBridge::BridgeMasterPort::schedTimingReq(PacketPtr pkt, Tick when)
         bridge.schedule(sendEvent, when);
     }
 
-    assert(transmitList.size() != reqQueueLimit);
-
-    transmitList.push_back(DeferredPacket(pkt, when));
+    uint16_t DSid = DSidQoS::classOf(pkt);
+    qos.take(DSid);
+    transmitList.push(DSid, DeferredPacket(pkt, when));
 }
 
 
@@ -242,9 +264,9 @@ TagBridge::BridgeSlavePort::schedTimingResp(PacketPtr pkt, Tick when)
     // This is a response for a request we forwarded earlier.  The
     // corresponding request state should be stored in the packet's
     // senderState field.
-    RequestState *req_state =
-        dynamic_cast<RequestState*>(pkt->popSenderState());
+    RequestState *req_state = RequestState::peek(pkt, &bridge);
     assert(req_state != NULL);
+    pkt->popSenderState();
     pkt->setDest(req_state->origSrc);
     delete req_state;
 
@@ -260,7 +282,7 @@ TagBridge::BridgeSlavePort::schedTimingResp(PacketPtr pkt, Tick when)
         bridge.schedule(sendEvent, when);
     }
 
-    transmitList.push_back(DeferredPacket(pkt, when));
+    transmitList.push(DSidQoS::classOf(pkt), DeferredPacket(pkt, when));
 }
 
 void
@@ -268,7 +290,8 @@ TagBridge::BridgeMasterPort::trySendTiming()
 {
     assert(!transmitList.empty());
 
-    DeferredPacket req = transmitList.front();
+    uint16_t DSid = transmitList.select(curTick());
+    DeferredPacket req = transmitList.front(DSid);
 
     assert(req.tick <= curTick());
 
@@ -279,21 +302,19 @@ TagBridge::BridgeMasterPort::trySendTiming()
 
     if (sendTimingReq(pkt)) {
         // send successful
-        transmitList.pop_front();
+        transmitList.pop(DSid);
+        qos.give(DSid);
         DPRINTF(TagBridge, "trySend request successful\n");
 
         // If there are more packets to send, schedule event to try again.
         if (!transmitList.empty()) {
-            DeferredPacket next_req = transmitList.front();
             DPRINTF(TagBridge, "Scheduling next send\n");
-            bridge.schedule(sendEvent, std::max(next_req.tick,
+            bridge.schedule(sendEvent, std::max(transmitList.nextTick(),
                                                 bridge.clockEdge()));
         }
 
-        // if we have stalled a request due to a full request queue,
-        // then send a retry at this point, also note that if the
-        // request we stalled was waiting for the response queue
-        // rather than the request queue we might stall it again
+        // if we have stalled a request, retry it once its DSid has
+        // space again
         slavePort.retryStalledReq();
     }
 
@@ -306,39 +327,33 @@ TagBridge::BridgeSlavePort::trySendTiming()
 {
     assert(!transmitList.empty());
 
-    DeferredPacket resp = transmitList.front();
+    uint16_t DSid = transmitList.select(curTick());
+    DeferredPacket resp = transmitList.front(DSid);
 
     assert(resp.tick <= curTick());
 
     PacketPtr pkt = resp.pkt;
 
     DPRINTF(TagBridge, "trySend response addr 0x%x, outstanding %d\n",
-            pkt->getAddr(), outstandingResponses);
+            pkt->getAddr(), qos.occupied());
 
     if (sendTimingResp(pkt)) {
         // send successful
-        transmitList.pop_front();
+        transmitList.pop(DSid);
         DPRINTF(TagBridge, "trySend response successful\n");
 
-        assert(outstandingResponses != 0);
-        --outstandingResponses;
+        qos.give(DSid);
 
         // If there are more packets to send, schedule event to try again.
         if (!transmitList.empty()) {
-            DeferredPacket next_resp = transmitList.front();
             DPRINTF(TagBridge, "Scheduling next send\n");
-            bridge.schedule(sendEvent, std::max(next_resp.tick,
+            bridge.schedule(sendEvent, std::max(transmitList.nextTick(),
                                                 bridge.clockEdge()));
         }
 
-        // if there is space in the request queue and we were stalling
-        // a request, it will definitely be possible to accept it now
-        // since there is guaranteed space in the response queue
-        if (!masterPort.reqQueueFull() && retryReq) {
-            DPRINTF(TagBridge, "Request waiting for retry, now retrying\n");
-            retryReq = false;
-            sendRetry();
-        }
+        // if we were stalling a request, retry it once its DSid has
+        // space again
+        retryStalledReq();
     }
 
     // if the send failed, then we try again once we receive a retry,
@@ -362,7 +377,7 @@ TagBridge::BridgeSlavePort::recvAtomic(PacketPtr pkt)
 {
     // attach DSid to pkt
     assert(!pkt->hasDSid());
-    pkt->setDSid(bridge.DSid);
+    pkt->setDSid(bridge.classifier.classify(pkt->getAddr()));
     return delay * bridge.clockPeriod() + masterPort.sendAtomic(pkt);
 }
 
@@ -373,14 +388,13 @@ TagBridge::BridgeSlavePort::recvFunctional(PacketPtr pkt)
 
     // attach DSid to pkt
     assert(!pkt->hasDSid());
-    pkt->setDSid(bridge.DSid);
+    pkt->setDSid(bridge.classifier.classify(pkt->getAddr()));
 
     // check the response queue
-    for (auto i = transmitList.begin();  i != transmitList.end(); ++i) {
-        if (pkt->checkFunctional((*i).pkt)) {
-            pkt->makeResponse();
-            return;
-        }
+    if (transmitList.find([pkt](const DeferredPacket &d)
+                          { return pkt->checkFunctional(d.pkt); })) {
+        pkt->makeResponse();
+        return;
     }
 
     // also check the master port's request queue
@@ -397,16 +411,10 @@ TagBridge::BridgeSlavePort::recvFunctional(PacketPtr pkt)
 bool
 TagBridge::BridgeMasterPort::checkFunctional(PacketPtr pkt)
 {
-    bool found = false;
-    auto i = transmitList.begin();
-
-    while(i != transmitList.end() && !found) {
-        if (pkt->checkFunctional((*i).pkt)) {
-            pkt->makeResponse();
-            found = true;
-        }
-        ++i;
-    }
+    bool found = transmitList.find([pkt](const DeferredPacket &d)
+                                   { return pkt->checkFunctional(d.pkt); });
+    if (found)
+        pkt->makeResponse();
 
     return found;
 }
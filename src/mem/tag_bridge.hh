@@ -40,6 +40,9 @@
 
 #include "base/types.hh"
 #include "mem/mem_object.hh"
+#include "mem/pard_dsid_classifier.hh"
+#include "mem/pard_qos_queue.hh"
+#include "mem/pard_sender_state.hh"
 #include "params/TagBridge.hh"
 
 /**
@@ -64,14 +67,15 @@ class TagBridge : public MemObject
      * state and original source. It has enough information to also
      * restore the response once it comes back to the bridge.
      */
-    class RequestState : public Packet::SenderState
+    class RequestState : public PooledSenderState<RequestState>
     {
 
       public:
 
         const PortID origSrc;
 
-        RequestState(PortID orig_src) : origSrc(orig_src)
+        RequestState(const TagBridge *owner, PortID orig_src)
+            : PooledSenderState<RequestState>(owner), origSrc(orig_src)
         { }
 
     };
@@ -120,29 +124,35 @@ class TagBridge : public MemObject
         /** Address ranges to pass through the bridge */
         const AddrRangeList ranges;
 
+        /**
+         * Space reserved for outstanding responses, per DSid. Taken
+         * when a request expecting a response is accepted and given
+         * back once the response is sent.
+         */
+        DSidQoS qos;
+
         /**
          * Response packet queue. Response packets are held in this
          * queue for a specified delay to model the processing delay
-         * of the bridge. We use a deque as we need to iterate over
-         * the items for functional accesses.
+         * of the bridge. Each DSid has its own sub-queue, served in
+         * order of priority.
          */
-        std::deque<DeferredPacket> transmitList;
-
-        /** Counter to track the outstanding responses. */
-        unsigned int outstandingResponses;
+        DSidQoSQueue<DeferredPacket> transmitList;
 
         /** If we should send a retry when space becomes available. */
         bool retryReq;
 
-        /** Max queue size for reserved responses. */
-        unsigned int respQueueLimit;
+        /** QoS class of the stalled request, and if it needs a response */
+        uint16_t retryDSid;
+        bool retryExpectsResp;
 
         /**
          * Is this side blocked from accepting new response packets.
          *
-         * @return true if the reserved space has reached the set limit
+         * @return true if DSid has used up its reserved and the shared
+         *         space
          */
-        bool respQueueFull() const;
+        bool respQueueFull(uint16_t DSid) const;
 
         /**
          * Handle send event, scheduled when the packet at the head of
@@ -183,7 +193,9 @@ class TagBridge : public MemObject
         /**
          * Retry any stalled request that we have failed to accept at
          * an earlier point in time. This call will do nothing if no
-         * request is waiting.
+         * request is waiting, or if its DSid still has no space in
+         * the request queue, or in the response queue if it expects a
+         * response.
          */
         void retryStalledReq();
 
@@ -232,16 +244,16 @@ class TagBridge : public MemObject
         /** Minimum delay though this bridge. */
         const Cycles delay;
 
+        /** Space of the request queue, per DSid */
+        DSidQoS qos;
+
         /**
          * Request packet queue. Request packets are held in this
          * queue for a specified delay to model the processing delay
-         * of the bridge.  We use a deque as we need to iterate over
-         * the items for functional accesses.
+         * of the bridge. Each DSid has its own sub-queue, served in
+         * order of priority.
          */
-        std::deque<DeferredPacket> transmitList;
-
-        /** Max queue size for request packets */
-        const unsigned int reqQueueLimit;
+        DSidQoSQueue<DeferredPacket> transmitList;
 
         /**
          * Handle send event, scheduled when the packet at the head of
@@ -276,6 +288,15 @@ class TagBridge : public MemObject
          */
         bool reqQueueFull() const;
 
+        /**
+         * Is this side blocked from accepting new request packets of
+         * DSid.
+         *
+         * @return true if DSid has used up its reserved and the shared
+         *         space
+         */
+        bool reqQueueFull(uint16_t DSid) const;
+
         /**
          * Queue a request packet to be sent out later and also schedule
          * a send if necessary.
@@ -316,7 +337,10 @@ class TagBridge : public MemObject
     uint16_t DSid;
 
     /** DSid base address */
-    Addr DSid_base_addr; 	// TODO: check req addr, if in range, return DSid
+    Addr DSid_base_addr;
+
+    /** DSid of each address range, DSid for the others */
+    DSidClassifier classifier;
 
   public:
 
@@ -328,6 +352,8 @@ class TagBridge : public MemObject
     virtual void init();
 
     typedef TagBridgeParams Params;
+    const Params *params() const
+    { return dynamic_cast<const Params *>(_params); }
 
     TagBridge(Params *p);
 };
@@ -44,6 +44,8 @@
 TagXBar::TagXBar(const TagXBarParams *p)
     : MemObject(p),
       DSid(p->DSid), DSid_base_addr(p->DSid_base_addr),
+      cp(p->cp), link(cp ? cp->regTagLink(name()) : -1),
+      reqWaitSince(MaxTick),
       xbar(p),
       slavePort(csprintf("%s.internal_slave", name()),
                 *this, InvalidPortID, masterPort),
@@ -65,9 +67,12 @@ TagXBar::recvTimingReq(PacketPtr pkt)
 
     bool needsResponse = pkt->needsResponse();
     bool memInhibitAsserted = pkt->memInhibitAsserted();
+    bool accounted = cp && !pkt->isExpressSnoop() && pkt->hasDSid();
+    uint16_t pkt_dsid = accounted ? pkt->getDSid() : 0;
+    unsigned int pkt_size = pkt->hasData() ? pkt->getSize() : 0;
 
     if (!memInhibitAsserted && needsResponse)
-        pkt->pushSenderState(new RequestState(pkt->getSrc()));
+        pkt->pushSenderState(new RequestState(this, pkt->getSrc()));
 
     // Attempt to send the packet (always succeeds for inhibited
     // packets)
@@ -77,20 +82,44 @@ TagXBar::recvTimingReq(PacketPtr pkt)
     if (!successful && needsResponse)
         delete pkt->popSenderState();
 
+    if (accounted) {
+        if (!successful) {
+            if (reqWaitSince == MaxTick)
+                reqWaitSince = curTick();
+            cp->recordRetry(pkt_dsid, link);
+        } else {
+            Tick queued = 0;
+            if (reqWaitSince != MaxTick) {
+                queued = curTick() - reqWaitSince;
+                reqWaitSince = MaxTick;
+            }
+            cp->recordTraffic(pkt_dsid, link, pkt_size, queued);
+        }
+    }
+
     return successful;
 }
 
+Tick
+TagXBar::recvAtomic(PacketPtr pkt)
+{
+    if (cp && pkt->hasDSid())
+        cp->recordTraffic(pkt->getDSid(), link,
+                          pkt->hasData() ? pkt->getSize() : 0, 0);
+    return masterPort.sendAtomic(pkt);
+}
+
 bool
 TagXBar::recvTimingResp(PacketPtr pkt)
 {
     DPRINTF(CoherentXBar, "TagXBar::recvTimingResp: %s 0x%x\n",
             pkt->cmdString(), pkt->getAddr());
-    RequestState *req_state =
-        dynamic_cast<RequestState*>(pkt->popSenderState());
+    RequestState *req_state = RequestState::peek(pkt, this);
     // panic if failed to restore initial sender state
     panic_if(!req_state,
              "TagXBar %s got a response without sender state.",
              name());
+    pkt->popSenderState();
 
     PortID dest = pkt->getDest();
 
@@ -122,7 +151,7 @@ TagXBar::recvTimingSnoopReq(PacketPtr pkt)
     bool memInhibitAsserted = pkt->memInhibitAsserted();
 
     if (!memInhibitAsserted && needsResponse)
-        pkt->pushSenderState(new RequestState(pkt->getSrc()));
+        pkt->pushSenderState(new RequestState(this, pkt->getSrc()));
 
     // Snoop request always success
     slavePort.sendTimingSnoopReq(pkt);
@@ -132,12 +161,12 @@ bool
 TagXBar::recvTimingSnoopResp(PacketPtr pkt)
 {
     DPRINTFN("TagXBar::recvTimingSnoopResp()\n");
-    RequestState *req_state =
-        dynamic_cast<RequestState*>(pkt->popSenderState());
+    RequestState *req_state = RequestState::peek(pkt, this);
     // panic if failed to restore initial sender state
     panic_if(!req_state,
              "TagXBar %s got a response without sender state.",
              name());
+    pkt->popSenderState();
 
     PortID dest = pkt->getDest();
 
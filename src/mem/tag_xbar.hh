@@ -37,6 +37,8 @@
 #define __MEM_TAG_XBAR_HH__
 
 #include "mem/coherent_xbar.hh"
+#include "mem/pard_sender_state.hh"
+#include "mem/pard_system_xbar_cp.hh"
 #include "params/TagXBar.hh"
 
 /**
@@ -47,11 +49,12 @@ class TagXBar : public MemObject
 {
   protected:
 
-    class RequestState : public Packet::SenderState
+    class RequestState : public PooledSenderState<RequestState>
     {
       public:
         const PortID origSrc;
-        RequestState(PortID orig_src) : origSrc(orig_src)
+        RequestState(const TagXBar *owner, PortID orig_src)
+            : PooledSenderState<RequestState>(owner), origSrc(orig_src)
         { }
     };
 
@@ -89,7 +92,7 @@ class TagXBar : public MemObject
 
         virtual Tick recvAtomic(PacketPtr pkt) {
             pkt->firstWordDelay = pkt->lastWordDelay = 0;
-            return masterPort.sendAtomic(pkt);
+            return xbar.recvAtomic(pkt);
         }
 
         virtual void recvFunctional(PacketPtr pkt) {
@@ -159,6 +162,14 @@ class TagXBar : public MemObject
     /** DSid base address */
     Addr DSid_base_addr;        // TODO: check req addr, if in range, return DSid
 
+    /** Control plane to account traffic to, may be NULL */
+    PARDSystemXBarCP *cp;
+    /** Link of this crossbar in cp */
+    int link;
+
+    /** Tick the last request was first refused, MaxTick if not waiting */
+    Tick reqWaitSince;
+
     /** Internal XBar */
     CoherentXBar xbar;
 
@@ -192,6 +203,7 @@ class TagXBar : public MemObject
 
   protected:
     bool recvTimingReq(PacketPtr pkt);
+    Tick recvAtomic(PacketPtr pkt);
     bool recvTimingResp(PacketPtr pkt);
     void recvTimingSnoopReq(PacketPtr pkt);
     bool recvTimingSnoopResp(PacketPtr pkt);
@@ -28,7 +28,9 @@
  * Authors: Jiuyue Ma
  */
 
+#include "debug/CPAdaptor.hh"
 #include "prm/CPAdaptor.hh"
+#include "prm/CPConnector.hh"
 
 struct REGISTER_MAP {
     uint32_t base;
@@ -52,8 +54,13 @@ REGISTER_MAP cpRegisterMap[] = {
 
 CPAdaptor::CPAdaptor(Params *p)
     : PciDevice(p),
-      masterPort(p->name + ".master", this)
+      masterPort(p->name + ".master", this),
+      statWindowSize(p->stat_window_size),
+      connectors(p->BAR2Size / p->stat_window_size, (CPConnector *)NULL),
+      maxBatch(p->max_batch), batchPending(0),
+      batchFetchEvent(this), batchDoneEvent(this)
 {
+    memset(&cpaRegs, 0, sizeof(cpaRegs));
 }
 
 void
@@ -69,6 +76,31 @@ CPAdaptor::recvResponse(PacketPtr pkt)
 }
 
 
+void
+CPAdaptor::postInterrupt(int cpDev)
+{
+    if (cpDev >= 64) {
+        warn("CPAdaptor: interrupt of CP#%d dropped\n", cpDev);
+        return;
+    }
+
+    DPRINTF(CPAdaptor, "post interrupt of CP#%d\n", cpDev);
+
+    cpaRegs.irqStatus |= ULL(1) << cpDev;
+    intrPost();
+}
+
+
+void
+CPAdaptor::registerConnector(int cpDev, CPConnector *connector)
+{
+    if (cpDev < 0 || (size_t)cpDev >= connectors.size()) {
+        warn("CPAdaptor: no statistics window for CP#%d\n", cpDev);
+        return;
+    }
+    connectors[cpDev] = connector;
+}
+
 // method to access cpaRegs
 void
 CPAdaptor::accessCommand(Addr offset, int size, uint8_t *data, bool read)
@@ -81,6 +113,35 @@ CPAdaptor::accessCommand(Addr offset, int size, uint8_t *data, bool read)
         else
             cpaRegs.command = *(uint32_t *)data;
         break;
+      case CPA_IRQ_STATUS_OFFSET:
+        assert (size == sizeof(uint64_t));
+        if (read) {
+            *(uint64_t *)data = cpaRegs.irqStatus;
+        } else {
+            cpaRegs.irqStatus &= ~*(uint64_t *)data;
+            if (!cpaRegs.irqStatus)
+                intrClear();
+        }
+        break;
+      case CPA_BATCH_BASE_OFFSET:
+        assert (size == sizeof(uint64_t));
+        if (read)
+            *(uint64_t *)data = cpaRegs.batchBase;
+        else
+            cpaRegs.batchBase = *(uint64_t *)data;
+        break;
+      case CPA_BATCH_DOORBELL_OFFSET:
+        assert (size == sizeof(uint32_t));
+        if (read)
+            *(uint32_t *)data = cpaRegs.batchDoorbell;
+        else
+            ringDoorbell(*(uint32_t *)data);
+        break;
+      case CPA_BATCH_STATUS_OFFSET:
+        assert (size == sizeof(uint32_t));
+        if (read)
+            *(uint32_t *)data = cpaRegs.batchStatus;
+        break;
       default:
         panic("Invalid CPAdaptor command register offset: %#x data %#x\n",
               offset, *data);
@@ -88,7 +149,7 @@ CPAdaptor::accessCommand(Addr offset, int size, uint8_t *data, bool read)
 }
 
 // method to access selected CPC's register space
-void
+Tick
 CPAdaptor::accessData(Addr offset, int size, uint8_t *data, bool read)
 {
     bool check_ok = false;
@@ -107,23 +168,114 @@ CPAdaptor::accessData(Addr offset, int size, uint8_t *data, bool read)
     if (!check_ok)
         panic("Invalid CPAdaptor data offset: %#x size: %#x \n", offset, size);
 
-    // Build request to CPN
-    Addr paddr = cpaRegs.command.selectCP*32 + offset;
-    RequestPtr req = new Request(paddr, size, Request::UNCACHEABLE,
-                                 Request::funcMasterId);
-    PacketPtr pkt = new Packet(req, read ? MemCmd::ReadReq : MemCmd::WriteReq);
-    pkt->dataStatic(data);
-    masterPort.sendAtomic(pkt);
-    delete pkt;
-    delete req;
+    // the access completes once the CPC has handled it
+    return accessCPN(cpaRegs.command.selectCP*32 + offset, size, data, read);
+}
+
+// method to access statistics windows, unpublished bytes read as 0xFF
+void
+CPAdaptor::accessStatWindow(Addr offset, int size, uint8_t *data, bool read)
+{
+    if (!read) {
+        warn("CPAdaptor: statistics window is read-only, %#x\n", offset);
+        return;
+    }
 
-    // maybe not response immediately, check dispatchAccess()
+    CPConnector *connector = connectors[offset / statWindowSize];
+    if (!connector ||
+        !connector->readStatWindow(offset % statWindowSize, size, data))
+        memset(data, 0xFF, size);
+}
+
+Tick
+CPAdaptor::accessCPN(Addr paddr, int size, uint8_t *data, bool read)
+{
+    cpnReq.setPhys(paddr, size, Request::UNCACHEABLE, Request::funcMasterId);
+    Packet pkt(&cpnReq, read ? MemCmd::ReadReq : MemCmd::WriteReq);
+    pkt.dataStatic(data);
+    return masterPort.sendAtomic(&pkt);
+}
+
+void
+CPAdaptor::ringDoorbell(uint32_t count)
+{
+    if (cpaRegs.batchStatus == CPA_BATCH_BUSY) {
+        warn("CPAdaptor: doorbell while a batch is running, ignored\n");
+        return;
+    }
+    if (count == 0 || count > maxBatch) {
+        warn("CPAdaptor: batch of %d descriptors out of range 1..%d\n",
+             count, maxBatch);
+        return;
+    }
+
+    DPRINTF(CPAdaptor, "batch of %d descriptors at %#x\n",
+            count, cpaRegs.batchBase);
+
+    cpaRegs.batchDoorbell = count;
+    cpaRegs.batchStatus = CPA_BATCH_BUSY;
+    batch.resize(count);
+    dmaRead(cpaRegs.batchBase, count * sizeof(CPABatchDesc),
+            &batchFetchEvent, (uint8_t *)&batch[0]);
+}
+
+void
+CPAdaptor::processBatch()
+{
+    // commands are issued back to back, so they overlap in the CPs,
+    // and the batch is written back once the last one took effect;
+    // they do not go through the CPN registers, which a driver may be
+    // using
+    batchPending = 0;
+    for (unsigned i = 0; i < batch.size(); i++) {
+        CPABatchDesc &desc = batch[i];
+        CPConnector *connector = CPConnector::find(desc.cpDev);
+        if (!connector) {
+            desc.status = CPA_DESC_ERROR;
+            continue;
+        }
+
+        batchPending++;
+        connector->issueCommand(desc.cmd, desc.LDomID, desc.destAddr,
+                                desc.data, this, i);
+    }
+
+    if (!batchPending)
+        writeBackBatch();
 }
 
-// access dispatcher
 void
+CPAdaptor::commandDone(uint64_t cookie, bool known, uint64_t data)
+{
+    assert(batchPending && cookie < batch.size());
+
+    CPABatchDesc &desc = batch[cookie];
+    desc.status = known ? CPA_DESC_DONE : CPA_DESC_ERROR;
+    desc.data = data;
+
+    if (--batchPending == 0)
+        writeBackBatch();
+}
+
+void
+CPAdaptor::writeBackBatch()
+{
+    dmaWrite(cpaRegs.batchBase, batch.size() * sizeof(CPABatchDesc),
+             &batchDoneEvent, (uint8_t *)&batch[0]);
+}
+
+void
+CPAdaptor::completeBatch()
+{
+    DPRINTF(CPAdaptor, "batch of %d descriptors done\n", batch.size());
+    cpaRegs.batchStatus = batch.size();
+}
+
+// access dispatcher
+Tick
 CPAdaptor::dispatchAccess(PacketPtr pkt, bool read)
 {
+    Tick latency = 0;
     int bar;
     Addr addr;
     if (!getBAR(pkt->getAddr(), bar, addr))
@@ -142,12 +294,15 @@ CPAdaptor::dispatchAccess(PacketPtr pkt, bool read)
     if (bar == 0)
         accessCommand(addr, size, dataPtr, read);
     else if (bar == 1)
-        accessData(addr, size, dataPtr, read);
+        latency = accessData(addr, size, dataPtr, read);
+    else if (bar == 2)
+        accessStatWindow(addr, size, dataPtr, read);
     else {
         panic("CPAdaptor access to invalid address; %#x\n", addr);
     }
 
     pkt->makeAtomicResponse();
+    return latency;
 }
 
 
@@ -31,12 +31,37 @@
 #ifndef __HYPER_GM_CPADAPTOR_HH__
 #define __HYPER_GM_CPADAPTOR_HH__
 
+#include <vector>
+
 #include "dev/pcidev.hh"
 #include "mem/mport.hh"
 #include "mem/packet.hh"
 #include "params/CPAdaptor.hh"
+#include "prm/interfaces.hh"
+
+class CPConnector;
+
+/**
+ * Descriptor of the command batch, run as if the command was written
+ * to CP#cpDev through BAR1, but leaving the BAR1 registers untouched.
+ * status is written back on completion, and so is data of a 'G' command.
+ */
+struct CPABatchDesc {
+    uint8_t  cmd;
+    uint8_t  status;
+    uint16_t LDomID;
+    uint32_t destAddr;
+    uint16_t cpDev;
+    uint16_t __padding[3];
+    uint64_t data;
+};
 
-class CPAdaptor : public PciDevice
+#define CPA_DESC_DONE		0x01
+#define CPA_DESC_ERROR		0x02
+
+#define CPA_BATCH_BUSY		0xFFFFFFFF
+
+class CPAdaptor : public PciDevice, public ICommandListener
 {
   protected:
 
@@ -64,6 +89,15 @@ class CPAdaptor : public PciDevice
 
     struct CPARegs {
         CPACommandReg command;
+        uint32_t __padding;
+        // bit i set: CP#i has fired trigger, write 1 to clear
+        uint64_t irqStatus;
+        // command batch: physical address of the CPABatchDesc array,
+        // writing N to batchDoorbell runs its first N descriptors,
+        // batchStatus is CPA_BATCH_BUSY until they are written back
+        uint64_t batchBase;
+        uint32_t batchDoorbell;
+        uint32_t batchStatus;
     } cpaRegs;
 
 /*
@@ -81,13 +115,41 @@ class CPAdaptor : public PciDevice
 
    
 
-    // access dispatcher
-    void dispatchAccess(PacketPtr pkt, bool read);
+    // access dispatcher, returns latency beyond pioDelay
+    Tick dispatchAccess(PacketPtr pkt, bool read);
 
     // method to access cpaRegs
     void accessCommand(Addr offset, int size, uint8_t *data, bool read);
-    // method to access selected CPC's register space
-    void accessData(Addr offset, int size, uint8_t *data, bool read);
+    // method to access selected CPC's register space, returns latency
+    // of the CPC
+    Tick accessData(Addr offset, int size, uint8_t *data, bool read);
+
+    // method to access statistics window of the CPs in BAR2
+    void accessStatWindow(Addr offset, int size, uint8_t *data, bool read);
+
+    // access of a CPC on the CPN, returns latency of the CPC
+    Tick accessCPN(Addr paddr, int size, uint8_t *data, bool read);
+
+    // reused by all CPN accesses
+    Request cpnReq;
+
+    // statistics window of CP#i at BAR2 offset i * statWindowSize
+    const Addr statWindowSize;
+    std::vector<CPConnector *> connectors;
+
+    // command batch
+    const unsigned maxBatch;
+    std::vector<struct CPABatchDesc> batch;
+    // descriptors issued and not completed yet
+    unsigned batchPending;
+
+    void ringDoorbell(uint32_t count);
+    void processBatch();
+    void writeBackBatch();
+    void completeBatch();
+
+    EventWrapper<CPAdaptor, &CPAdaptor::processBatch> batchFetchEvent;
+    EventWrapper<CPAdaptor, &CPAdaptor::completeBatch> batchDoneEvent;
 
   public:
 
@@ -106,8 +168,8 @@ class CPAdaptor : public PciDevice
    **/
   public:
 
-    virtual Tick  read(PacketPtr pkt) { dispatchAccess(pkt, true); return pioDelay; }
-    virtual Tick write(PacketPtr pkt) { dispatchAccess(pkt, false); return pioDelay; }
+    virtual Tick  read(PacketPtr pkt) { return pioDelay + dispatchAccess(pkt, true); }
+    virtual Tick write(PacketPtr pkt) { return pioDelay + dispatchAccess(pkt, false); }
 
 
   /**
@@ -117,8 +179,21 @@ class CPAdaptor : public PciDevice
 
     Tick recvResponse(PacketPtr pkt);
 
+    /** Post trigger interrupt of CP#cpDev */
+    void postInterrupt(int cpDev);
+
+    /** Map statistics window of CP#cpDev */
+    void registerConnector(int cpDev, CPConnector *connector);
+
+    /** Descriptor #cookie of the batch took effect */
+    void commandDone(uint64_t cookie, bool known, uint64_t data);
+
 };
 
 #define CPA_COMMAND_OFFSET	(0)
+#define CPA_IRQ_STATUS_OFFSET	(8)
+#define CPA_BATCH_BASE_OFFSET	(16)
+#define CPA_BATCH_DOORBELL_OFFSET	(24)
+#define CPA_BATCH_STATUS_OFFSET	(28)
 
 #endif //__HYPER_GM_CPADAPTOR_HH__
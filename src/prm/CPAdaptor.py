@@ -15,9 +15,18 @@ class CPAdaptor(PciDevice):
     ClassCode = 0x06		# Bridge Devices
     SubClassCode = 0x80		# Other bridge type
     ProgIF = 0x00
-    BAR0 = 0x00000000		# CP selector register
+    BAR0 = 0x00000000		# CP selector, interrupt status & command batch
     BAR1 = 0x00000000		# map to selected CP address space
-    BAR0Size = '4B'
+    BAR2 = 0x00000000		# statistics windows of the CPs, read-only
+    BAR0Size = '32B'
     BAR1Size = '32B'
+    BAR2Size = '1MB'
     InterruptLine = 0x1a
     InterruptPin = 0x01
+
+    # Statistics window of CP#i starts at BAR2 offset i * stat_window_size
+    stat_window_size = Param.MemorySize32('16kB',
+                      "Size of the statistics window of each CP")
+
+    # Largest command batch accepted by one doorbell
+    max_batch = Param.Unsigned(256, "Maximum descriptors per batch")
@@ -28,20 +28,47 @@
  * Authors: Jiuyue Ma
  */
 
+#include <algorithm>
+
+#include "prm/CPAdaptor.hh"
 #include "prm/CPConnector.hh"
 #include "prm/ControlPlane.hh"
 #include "debug/CPConnector.hh"
+#include "debug/Drain.hh"
+
+std::vector<CPConnector *> CPConnector::connectorList;
 
 CPConnector::CPConnector(Params *p)
     : MemObject(p),
       slavePort(p->name + ".slave", this),
       masterPort(p->name + ".master", this),
-      cp(NULL), cmdHandler(NULL),
-      cpDevID(p->cp_dev)
+      cp(NULL), adaptor(p->adaptor),
+      cpDevID(p->cp_dev),
+      regLatency(p->reg_latency),
+      queryLatency(p->query_latency),
+      updateLatency(p->update_latency),
+      cmdPipelineDepth(p->cmd_pipeline_depth),
+      lastCmdStart(0), lastDone(0),
+      drainManager(NULL), commandEvent(this)
 {
+    fatal_if(cmdPipelineDepth == 0, "%s: cmd_pipeline_depth must be "
+             "non-zero\n", name());
+
     memset(&regs, 0xFF, sizeof(regs));
     regs.cpType = p->Type;
     strncpy((char *)regs.cpIdent, p->IDENT.c_str(), 12);
+
+    connectorList.push_back(this);
+}
+
+CPConnector *
+CPConnector::find(int cpDev)
+{
+    for (auto connector : connectorList) {
+        if (connector->cpDevID == cpDev)
+            return connector;
+    }
+    return NULL;
 }
 
 void
@@ -54,6 +81,26 @@ CPConnector::init()
 
     // notify the master side  of our address ranges
     slavePort.sendRangeChange();
+
+    if (adaptor)
+        adaptor->registerConnector(cpDevID, this);
+}
+
+unsigned int
+CPConnector::drain(DrainManager *dm)
+{
+    unsigned int count = slavePort.drain(dm);
+
+    // commands yet to take effect
+    if (!pendingCommands.empty()) {
+        DPRINTF(Drain, "%s: %d CP commands pending\n", name(),
+                pendingCommands.size());
+        drainManager = dm;
+        count++;
+    }
+
+    setDrainState(count ? Drainable::Draining : Drainable::Drained);
+    return count;
 }
 
 BaseMasterPort&
@@ -99,12 +146,136 @@ CPConnector::getAddrRanges() const
 
 #define OFFSET_OF(type, field) ((long)(&((type *)0)->field))
 
+bool
+CPConnector::isCommandAccess(PacketPtr pkt) const
+{
+    Addr offset = pkt->getAddr() - cpDevID*32;
+    return offset == OFFSET_OF(CPConnRegs, cpCmd);
+}
+
+Tick
+CPConnector::reserveCommand(uint8_t cmd)
+{
+    while (!cmdDone.empty() && cmdDone.front() <= curTick())
+        cmdDone.pop_front();
+
+    Tick latency = (cmd == 'G') ? queryLatency : updateLatency;
+
+    // issue in order, once the command cmdPipelineDepth before
+    // this one is done
+    Tick start = std::max(curTick(), lastCmdStart);
+    if (cmdDone.size() >= cmdPipelineDepth)
+        start = std::max(start, cmdDone[cmdDone.size() - cmdPipelineDepth]);
+    lastCmdStart = start;
+
+    Tick done = std::max(start + latency, lastDone);
+    cmdDone.push_back(done);
+
+    lastDone = done;
+    return done;
+}
+
+Tick
+CPConnector::reserveAccess(PacketPtr pkt)
+{
+    if (isCommandAccess(pkt)) {
+        uint8_t cmd = pkt->isWrite() ? *pkt->getPtr<uint8_t>() : regs.cpCmd;
+        return reserveCommand(cmd);
+    }
+
+    lastDone = std::max(curTick(), lastDone) + regLatency;
+    return lastDone;
+}
+
 Tick
 CPConnector::recvAtomic(PacketPtr pkt)
+{
+    Tick done = reserveAccess(pkt);
+
+    access(pkt);
+    if (isCommandAccess(pkt))
+        queueCommand(done, regs.cpCmd, regs.cpLDomID, regs.cpDestAddr,
+                     regs.cpData, NULL, 0);
+    if (pkt->needsResponse())
+        pkt->makeAtomicResponse();
+
+    return done - curTick();
+}
+
+void
+CPConnector::recvFunctional(PacketPtr pkt)
+{
+    access(pkt);
+    if (isCommandAccess(pkt) &&
+        !execCommand(regs.cpCmd, regs.cpLDomID, regs.cpDestAddr,
+                     &regs.cpData))
+        regs.cpCmd = 0xFF;
+}
+
+Tick
+CPConnector::issueCommand(uint8_t cmd, uint16_t LDomID, uint32_t destAddr,
+                          uint64_t data, ICommandListener *listener,
+                          uint64_t cookie)
+{
+    Tick done = reserveCommand(cmd);
+    queueCommand(done, cmd, LDomID, destAddr, data, listener, cookie);
+    return done;
+}
+
+void
+CPConnector::queueCommand(Tick done, uint8_t cmd, uint16_t LDomID,
+                          uint32_t destAddr, uint64_t data,
+                          ICommandListener *listener, uint64_t cookie)
+{
+    // completion ticks never decrease, see reserveCommand()
+    assert(pendingCommands.empty() || pendingCommands.back().done <= done);
+
+    PendingCommand pending = { done, cmd, LDomID, destAddr, data,
+                               listener, cookie };
+    pendingCommands.push_back(pending);
+    if (!commandEvent.scheduled())
+        schedule(commandEvent, done);
+
+    DPRINTF(CPConnector, "cmd '%c' LDom#%d addr 0x%x takes effect at %d\n",
+            cmd, LDomID, destAddr, done);
+}
+
+void
+CPConnector::processCommand()
+{
+    while (!pendingCommands.empty() &&
+           pendingCommands.front().done <= curTick()) {
+        PendingCommand pending = pendingCommands.front();
+        pendingCommands.pop_front();
+
+        bool known = execCommand(pending.cmd, pending.LDomID,
+                                 pending.destAddr, &pending.data);
+        if (pending.listener) {
+            pending.listener->commandDone(pending.cookie, known,
+                                          pending.data);
+        } else {
+            if (pending.cmd == 'G')
+                regs.cpData = pending.data;
+            if (!known)
+                regs.cpCmd = 0xFF;
+        }
+    }
+
+    if (!pendingCommands.empty())
+        schedule(commandEvent, pendingCommands.front().done);
+
+    if (drainManager && pendingCommands.empty()) {
+        drainManager->signalDrainDone();
+        drainManager = NULL;
+    }
+}
+
+void
+CPConnector::access(PacketPtr pkt)
 {
     Addr offset = pkt->getAddr() - cpDevID*32;
 
-    DPRINTF(CPConnector, "CPConnector::recvAtomic(offset=0x%lx, size=0x%lx)\n", offset, pkt->getSize());
+    DPRINTF(CPConnector, "CPConnector::access(offset=0x%lx, size=0x%lx)\n", offset, pkt->getSize());
 
     // check access right, access must in reg field boundary & size in (1,2,4,8)
     assert((offset == OFFSET_OF(CPConnRegs, cpType))		||
@@ -125,32 +296,61 @@ CPConnector::recvAtomic(PacketPtr pkt)
         memcpy(((char *)&regs) + offset, pkt->getPtr<char *>(), pkt->getSize());
     else
         panic("Error type\n");
+}
 
-    // special for cpCmd register
-    if (offset == OFFSET_OF(CPConnRegs, cpCmd)) {
-        if (regs.cpCmd == 'G')
-            regs.cpData = cp->queryTable(regs.cpLDomID, regs.cpDestAddr);
-        else if (regs.cpCmd == 'S')
-            cp->updateTable(regs.cpLDomID, regs.cpDestAddr, regs.cpData);
-        else {
-            bool cmd_handled = false;
-            if (cmdHandler) {
-                cmd_handled = cmdHandler->handleCommand(
-                    regs.cpCmd,
-                    (uint64_t)regs.cpLDomID,
-                    (uint64_t)regs.cpDestAddr,
-                    (uint64_t)regs.cpData
-                );
-            }
-            if (!cmd_handled) {
-                warn("Unknown ControlPlane Command: 0x%x.\n", regs.cpCmd);
-                regs.cpCmd = 0xFF;
-            }
+bool
+CPConnector::execCommand(uint8_t cmd, uint16_t LDomID, uint32_t destAddr,
+                         uint64_t *data)
+{
+    if ((cmd == 'G' || cmd == 'S') && !cp)
+        return false;
+
+    if (cmd == 'G')
+        *data = cp->queryTable(LDomID, destAddr);
+    else if (cmd == 'S')
+        cp->updateTable(LDomID, destAddr, *data);
+    else {
+        bool cmd_handled = false;
+        for (auto handler : cmdHandlers) {
+            cmd_handled = handler->handleCommand(
+                cmd,
+                (uint64_t)LDomID,
+                (uint64_t)destAddr,
+                (uint64_t)*data
+            );
+            if (cmd_handled)
+                break;
+        }
+        if (!cmd_handled) {
+            warn("Unknown ControlPlane Command: 0x%x.\n", cmd);
+            return false;
         }
-        return 3;
     }
+    return true;
+}
 
-    return 1;
+void
+CPConnector::raiseInterrupt()
+{
+    DPRINTF(CPConnector, "raise interrupt of CP#%d\n", cpDevID);
+
+    if (adaptor)
+        adaptor->postInterrupt(cpDevID);
+    else
+        warn_once("%s: no CPAdaptor to raise interrupt\n", name());
+}
+
+bool
+CPConnector::runCommand(uint8_t cmd, uint16_t LDomID, uint32_t destAddr,
+                        uint64_t *data)
+{
+    return execCommand(cmd, LDomID, destAddr, data);
+}
+
+bool
+CPConnector::readStatWindow(Addr offset, int size, uint8_t *data)
+{
+    return cp && cp->readStatWindow(offset, size, data);
 }
 
 Tick
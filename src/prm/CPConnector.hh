@@ -31,6 +31,9 @@
 #ifndef __PRM_CP_CONNECTOR_HH__
 #define __PRM_CP_CONNECTOR_HH__
 
+#include <deque>
+#include <vector>
+
 #include "mem/mem_object.hh"
 #include "mem/tport.hh"
 #include "mem/mport.hh"
@@ -39,6 +42,7 @@
 #include "params/CPConnector.hh"
 
 class ControlPlane;
+class CPAdaptor;
 
 class CPConnector : public MemObject
 {
@@ -62,6 +66,13 @@ class CPConnector : public MemObject
             pkt->firstWordDelay = pkt->lastWordDelay = 0;
             return agent->recvAtomic(pkt);
         }
+
+        void recvFunctional(PacketPtr pkt)
+        {
+            agent->recvFunctional(pkt);
+            if (pkt->needsResponse())
+                pkt->makeResponse();
+        }
     };
 
     class CPConnectorMasterPort : public MessageMasterPort
@@ -89,6 +100,7 @@ class CPConnector : public MemObject
     CPConnector(Params *p);
 
     virtual void init();
+    virtual unsigned int drain(DrainManager *dm);
 
     virtual BaseMasterPort& getMasterPort(const std::string& if_name,
                                           PortID idx = InvalidPortID);
@@ -98,13 +110,16 @@ class CPConnector : public MemObject
   public:
 
     Tick recvAtomic(PacketPtr pkt);
+    /** No latency booked, a command written takes effect at once */
+    void recvFunctional(PacketPtr pkt);
     Tick recvResponse(PacketPtr pkt);
     AddrRangeList getAddrRanges() const;
 
   protected:
 
     ControlPlane *cp;
-    ICommandHandler *cmdHandler;
+    // tried in registration order until one accepts the command
+    std::vector<ICommandHandler *> cmdHandlers;
 
   public:
 
@@ -112,7 +127,59 @@ class CPConnector : public MemObject
     { assert(!cp); cp = _cp; }
 
     void registerCommandHandler(ICommandHandler *handler)
-    { assert(!cmdHandler); cmdHandler = handler; }
+    { cmdHandlers.push_back(handler); }
+
+    /** Raise a trigger interrupt of this CP to the PRM */
+    void raiseInterrupt();
+
+    /** Read the statistics window of this CP, see ControlPlane */
+    bool readStatWindow(Addr offset, int size, uint8_t *data);
+
+    /**
+     * Run a command at once from outside the CPN (see CPServer), the
+     * registers seen through the CPN are left untouched.
+     *
+     * @param data argument, result of a 'G' command on return
+     * @return false if the command is unknown
+     */
+    bool runCommand(uint8_t cmd, uint16_t LDomID, uint32_t destAddr,
+                    uint64_t *data);
+
+    /**
+     * Issue a command as if written to the registers, which are left
+     * untouched (see CPAdaptor batches). It is booked in the latency
+     * model and takes effect at its completion tick, when listener is
+     * told with cookie.
+     *
+     * @return completion tick of the command
+     */
+    Tick issueCommand(uint8_t cmd, uint16_t LDomID, uint32_t destAddr,
+                      uint64_t data, ICommandListener *listener,
+                      uint64_t cookie);
+
+    int getCPDev() const { return cpDevID; }
+
+    /** All connectors, in construction order */
+    static std::vector<CPConnector *> connectorList;
+    static CPConnector *find(int cpDev);
+
+  protected:
+
+    /** Access the registers at once, commands are not run */
+    void access(PacketPtr pkt);
+
+    /**
+     * Run a command now
+     *
+     * @param data argument, result of a 'G' command on return
+     * @return false if the command is unknown
+     */
+    bool execCommand(uint8_t cmd, uint16_t LDomID, uint32_t destAddr,
+                     uint64_t *data);
+
+  protected:
+
+    CPAdaptor *adaptor;
 
   protected:
 
@@ -127,6 +194,60 @@ class CPConnector : public MemObject
         uint64_t cpData;
     } regs;
 
+  protected:
+
+    /**
+     * Latency model of the CP. Accesses complete in order; a command
+     * takes query_latency ('G') or update_latency (others), and up to
+     * cmd_pipeline_depth commands overlap, so a stream of commands,
+     * such as a CPAdaptor batch, is pipelined. Any other register
+     * access waits for the commands before it and takes reg_latency.
+     * The registers are accessed at once, but a command only takes
+     * effect at its completion tick; the result of a command written
+     * to cpCmd is then put in cpData, and cpCmd is set to 0xFF if the
+     * command is unknown. A timing request is answered by the
+     * SimpleTimingPort once the modeled latency has passed.
+     */
+    const Tick regLatency;
+    const Tick queryLatency;
+    const Tick updateLatency;
+    const unsigned cmdPipelineDepth;
+
+    // completion tick of the commands still running, in issue order
+    std::deque<Tick> cmdDone;
+    Tick lastCmdStart;
+    Tick lastDone;
+
+    bool isCommandAccess(PacketPtr pkt) const;
+
+    /** Book pkt in the latency model, returns its completion tick */
+    Tick reserveAccess(PacketPtr pkt);
+    Tick reserveCommand(uint8_t cmd);
+
+    /**
+     * Commands booked but not run yet, in completion order. Those
+     * written to cpCmd have no listener.
+     */
+    struct PendingCommand {
+        Tick done;
+        uint8_t cmd;
+        uint16_t LDomID;
+        uint32_t destAddr;
+        uint64_t data;
+        ICommandListener *listener;
+        uint64_t cookie;
+    };
+    std::deque<PendingCommand> pendingCommands;
+    DrainManager *drainManager;
+
+    void queueCommand(Tick done, uint8_t cmd, uint16_t LDomID,
+                      uint32_t destAddr, uint64_t data,
+                      ICommandListener *listener, uint64_t cookie);
+    void processCommand();
+    EventWrapper<CPConnector, &CPConnector::processCommand> commandEvent;
+
+  protected:
+
     const Params * param() const
     { return dynamic_cast<const Params *>(_params); }
 
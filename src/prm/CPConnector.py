@@ -14,3 +14,12 @@ class CPConnector(MemObject):
     IDENT = Param.String("GenCP", "Identifier of this CP, 12-byte maximum")
     BAR0 = Param.UInt32(0x00, "Base Address Register 0")
     BAR0Size = Param.MemorySize32('0B', "Base Address Register 0 Size")
+
+    # Trigger interrupts are raised through this adaptor
+    adaptor = Param.CPAdaptor(NULL, "CPAdaptor to raise interrupts")
+
+    # Latency model of the CP, see CPConnector.hh
+    reg_latency = Param.Latency('1ns', "Latency of a register access")
+    query_latency = Param.Latency('10ns', "Latency of a 'G' command")
+    update_latency = Param.Latency('20ns', "Latency of other commands")
+    cmd_pipeline_depth = Param.Unsigned(1, "Commands the CP runs at once")
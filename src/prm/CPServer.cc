@@ -0,0 +1,170 @@
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <cassert>
+#include <cerrno>
+#include <cstring>
+
+#include "base/misc.hh"
+#include "base/output.hh"
+#include "debug/CPServer.hh"
+#include "prm/CPConnector.hh"
+#include "prm/CPServer.hh"
+
+CPServer::CPServer(const Params *p)
+    : SimObject(p), path(simout.resolve(p->socket_path)),
+      listenFd(-1), listenEvent(NULL)
+{
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    fatal_if(path.size() >= sizeof(addr.sun_path),
+             "%s: socket path %s too long\n", name(), path);
+    strncpy(addr.sun_path, path.c_str(), sizeof(addr.sun_path) - 1);
+
+    listenFd = socket(AF_UNIX, SOCK_STREAM, 0);
+    fatal_if(listenFd < 0, "%s: cannot create socket: %s\n", name(),
+             strerror(errno));
+
+    unlink(path.c_str());
+    if (bind(listenFd, (struct sockaddr *)&addr, sizeof(addr)) < 0 ||
+        listen(listenFd, 1) < 0)
+        fatal("%s: cannot listen on %s: %s\n", name(), path,
+              strerror(errno));
+
+    inform("Listening for control plane connection on %s\n", path);
+    listenEvent = new ListenEvent(this, listenFd, POLLIN|POLLERR);
+    pollQueue.schedule(listenEvent);
+}
+
+CPServer::~CPServer()
+{
+    while (!clients.empty())
+        detach(clients.begin()->first);
+
+    delete listenEvent;
+    if (listenFd >= 0) {
+        close(listenFd);
+        unlink(path.c_str());
+    }
+}
+
+void
+CPServer::accept()
+{
+    // called from the PollQueue, maybe from a different thread
+    EventQueue::ScopedMigration migrate(eventQueue());
+
+    int fd = ::accept(listenFd, NULL, NULL);
+    if (fd < 0) {
+        warn("%s: accept failed: %s\n", name(), strerror(errno));
+        return;
+    }
+
+    DPRINTF(CPServer, "client %d attached\n", fd);
+    Client &client = clients[fd];
+    client.event = new ClientEvent(this, fd, POLLIN|POLLERR);
+    pollQueue.schedule(client.event);
+}
+
+void
+CPServer::detach(int fd)
+{
+    DPRINTF(CPServer, "client %d detached\n", fd);
+
+    auto it = clients.find(fd);
+    assert(it != clients.end());
+    delete it->second.event;
+    clients.erase(it);
+    close(fd);
+}
+
+void
+CPServer::runBatch(CPABatchDesc *descs, uint32_t count)
+{
+    for (uint32_t i = 0; i < count; i++) {
+        CPABatchDesc &desc = descs[i];
+        CPConnector *connector = CPConnector::find(desc.cpDev);
+
+        if (connector &&
+            connector->runCommand(desc.cmd, desc.LDomID, desc.destAddr,
+                                  &desc.data))
+            desc.status = CPA_DESC_DONE;
+        else
+            desc.status = CPA_DESC_ERROR;
+
+        DPRINTF(CPServer, "CP#%d cmd '%c' LDom#%d addr 0x%x: data 0x%x, "
+                "status %d\n", desc.cpDev, desc.cmd, desc.LDomID,
+                desc.destAddr, desc.data, desc.status);
+    }
+}
+
+void
+CPServer::serve(int fd, int revent)
+{
+    EventQueue::ScopedMigration migrate(eventQueue());
+
+    if (revent & POLLERR) {
+        detach(fd);
+        return;
+    }
+    if (!(revent & POLLIN))
+        return;
+
+    std::vector<uint8_t> &buf = clients[fd].rxBuf;
+    uint8_t data[4096];
+    ssize_t len = read(fd, data, sizeof(data));
+    if (len <= 0) {
+        detach(fd);
+        return;
+    }
+    buf.insert(buf.end(), data, data + len);
+
+    // serve every complete request, the reply reuses its buffer
+    while (buf.size() >= sizeof(CPServerMsgHdr)) {
+        CPServerMsgHdr hdr;
+        memcpy(&hdr, &buf[0], sizeof(hdr));
+        if (hdr.count > CPSERVER_MAX_BATCH) {
+            warn("%s: batch of %d descriptors too large, drop client\n",
+                 name(), hdr.count);
+            detach(fd);
+            return;
+        }
+
+        size_t msg_len = sizeof(hdr) + hdr.count * sizeof(CPABatchDesc);
+        if (buf.size() < msg_len)
+            break;
+
+        std::vector<CPABatchDesc> descs(hdr.count);
+        if (hdr.count)
+            memcpy(&descs[0], &buf[sizeof(hdr)],
+                   hdr.count * sizeof(CPABatchDesc));
+        runBatch(descs.data(), hdr.count);
+        if (hdr.count)
+            memcpy(&buf[sizeof(hdr)], &descs[0],
+                   hdr.count * sizeof(CPABatchDesc));
+
+        size_t sent = 0;
+        while (sent < msg_len) {
+            ssize_t ret = write(fd, &buf[sent], msg_len - sent);
+            if (ret < 0 && errno == EINTR)
+                continue;
+            if (ret <= 0) {
+                warn("%s: cannot reply to client: %s\n", name(),
+                     strerror(errno));
+                detach(fd);
+                return;
+            }
+            sent += ret;
+        }
+
+        buf.erase(buf.begin(), buf.begin() + msg_len);
+    }
+}
+
+CPServer *
+CPServerParams::create()
+{
+    return new CPServer(this);
+}
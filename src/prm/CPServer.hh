@@ -0,0 +1,77 @@
+#ifndef __PRM_CP_SERVER_HH__
+#define __PRM_CP_SERVER_HH__
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "base/pollevent.hh"
+#include "params/CPServer.hh"
+#include "prm/CPAdaptor.hh"
+#include "sim/sim_object.hh"
+
+/**
+ * Host-side access to the control planes over a Unix-domain socket.
+ *
+ * A client sends a CPServerMsgHdr followed by `count' CPABatchDesc,
+ * each run as if written to CP#cpDev through the CPAdaptor. The reply
+ * is the same header and descriptors with status and data filled in.
+ * Sockets are driven by the pollQueue, requests are served between
+ * simulation events.
+ */
+struct CPServerMsgHdr {
+    uint32_t count;
+    uint32_t __padding;
+};
+
+#define CPSERVER_MAX_BATCH	1024
+
+class CPServer : public SimObject
+{
+  protected:
+
+    class ListenEvent : public PollEvent
+    {
+        CPServer *server;
+
+      public:
+        ListenEvent(CPServer *_server, int fd, int e)
+            : PollEvent(fd, e), server(_server) {}
+        virtual void process(int revent) { server->accept(); }
+    };
+
+    class ClientEvent : public PollEvent
+    {
+        CPServer *server;
+
+      public:
+        ClientEvent(CPServer *_server, int fd, int e)
+            : PollEvent(fd, e), server(_server) {}
+        virtual void process(int revent)
+        { server->serve(getfd(), revent); }
+    };
+
+    std::string path;
+    int listenFd;
+    ListenEvent *listenEvent;
+
+    struct Client {
+        ClientEvent *event;
+        std::vector<uint8_t> rxBuf;
+    };
+    std::map<int, Client> clients;
+
+    void accept();
+    void serve(int fd, int revent);
+    void detach(int fd);
+
+    /** Run a batch in place */
+    void runBatch(CPABatchDesc *descs, uint32_t count);
+
+  public:
+    typedef CPServerParams Params;
+    CPServer(const Params *p);
+    ~CPServer();
+};
+
+#endif	// __PRM_CP_SERVER_HH__
@@ -0,0 +1,9 @@
+from m5.SimObject import SimObject
+from m5.params import *
+
+class CPServer(SimObject):
+    type = 'CPServer'
+    cxx_header = "prm/CPServer.hh"
+
+    # Relative paths are resolved in the output directory
+    socket_path = Param.String("cpserver.sock", "Unix socket to listen on")
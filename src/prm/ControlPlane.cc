@@ -1,14 +1,28 @@
+#include "base/misc.hh"
+#include "debug/ControlPlane.hh"
 #include "prm/CPConnector.hh"
 #include "prm/ControlPlane.hh"
 
 ControlPlane::ControlPlane(const Params *p)
-    : AbstractControlPlane(p), connector(p->connector)
+    : AbstractControlPlane(p), connector(p->connector),
+      trigger_table_entries(p->trigger_table_entries),
+      triggerEpoch(p->trigger_epoch),
+      statWindow(p->stat_window),
+      triggerEvent(this)
 {
     connector->registerControlPlane(this);
+
+    fatal_if(trigger_table_entries && !triggerEpoch,
+             "%s: trigger_epoch must be non-zero\n", name());
+
+    // Allocate TriggerTable
+    triggerTable = new struct TriggerEntry[trigger_table_entries];
+    memset(triggerTable, 0, sizeof(struct TriggerEntry)*trigger_table_entries);
 }
 
 ControlPlane::~ControlPlane()
 {
+    delete[] triggerTable;
 }
 
 void
@@ -17,3 +31,177 @@ ControlPlane::registerCommandHandler(ICommandHandler *handler)
     connector->registerCommandHandler(handler);
 }
 
+bool
+ControlPlane::readStatWindow(Addr offset, int size, uint8_t *data)
+{
+    size_t entry_size = statEntrySize();
+    if (!statWindow || !entry_size)
+        return false;
+
+    Addr field = offset & ~(Addr)(sizeof(uint64_t) - 1);
+    int row = field / entry_size;
+    unsigned row_offset = field % entry_size;
+    if (row >= statTableEntries() ||
+        offset - field + size > sizeof(uint64_t))
+        return false;
+
+    uint32_t stat_addr = ADDRTYPE_CFGTBL |
+                         (CFGTBL_TYPE_STAT << 28) |
+                         (row << 10) | row_offset;
+    uint64_t value = queryTable(0, stat_addr);
+    memcpy(data, (uint8_t *)&value + (offset - field), size);
+    return true;
+}
+
+bool
+ControlPlane::isTriggerAddr(uint32_t addr) const
+{
+    return (addr & ADDRTYPE_MASK) == ADDRTYPE_CFGTBL &&
+           cfgtbl_addr2type(addr) == CFGTBL_TYPE_TRIGGER;
+}
+
+uint64_t *
+ControlPlane::parseTriggerAddr(uint32_t addr)
+{
+    int row = cfgtbl_addr2row(addr);
+    unsigned offset = cfgtbl_addr2offset(addr);
+
+    if (!isTriggerAddr(addr) || row >= trigger_table_entries ||
+        offset > sizeof(struct TriggerEntry) - sizeof(uint64_t))
+        return NULL;
+
+    return (uint64_t *)((char *)&triggerTable[row] + offset);
+}
+
+uint64_t
+ControlPlane::queryTrigger(uint32_t addr)
+{
+    uint64_t *pdata = parseTriggerAddr(addr);
+    if (!pdata) {
+        warn("%s: unknown trigger addr 0x%x", name(), addr);
+        return 0xFFFFFFFFFFFFFFFF;
+    }
+    return *pdata;
+}
+
+void
+ControlPlane::updateTrigger(uint32_t addr, uint64_t data)
+{
+    uint64_t *pdata = parseTriggerAddr(addr);
+    if (!pdata) {
+        warn("%s: unknown trigger addr 0x%x", name(), addr);
+        return;
+    }
+
+    int row = cfgtbl_addr2row(addr);
+    TriggerEntry &trigger = triggerTable[row];
+    bool was_valid = trigger.flags & TRIGGER_FLAG_VALID;
+
+    *pdata = data;
+
+    // (re-)arm the trigger when it becomes valid
+    if (!was_valid && (trigger.flags & TRIGGER_FLAG_VALID)) {
+        trigger.flags &= ~TRIGGER_FLAG_FIRED;
+        trigger.fire_count = 0;
+        DPRINTF(ControlPlane, "trigger #%d armed: DSid=%d, stat 0x%x "
+                "op %d threshold %d, action 0x%x\n", row, trigger.DSid,
+                trigger.stat_offset, trigger.op, trigger.threshold,
+                trigger.action);
+        if (!triggerEvent.scheduled())
+            schedule(triggerEvent, curTick() + triggerEpoch);
+    }
+}
+
+bool
+ControlPlane::anyValidTrigger() const
+{
+    for (int i = 0; i < trigger_table_entries; i++) {
+        if (triggerTable[i].flags & TRIGGER_FLAG_VALID)
+            return true;
+    }
+    return false;
+}
+
+bool
+ControlPlane::evalTrigger(const TriggerEntry &trigger, uint64_t value) const
+{
+    switch (trigger.op) {
+      case TRIGGER_OP_GT: return value >  trigger.threshold;
+      case TRIGGER_OP_GE: return value >= trigger.threshold;
+      case TRIGGER_OP_LT: return value <  trigger.threshold;
+      case TRIGGER_OP_LE: return value <= trigger.threshold;
+      case TRIGGER_OP_EQ: return value == trigger.threshold;
+      case TRIGGER_OP_NE: return value != trigger.threshold;
+      default:            return false;
+    }
+}
+
+void
+ControlPlane::fireTrigger(int idx, int row)
+{
+    TriggerEntry &trigger = triggerTable[idx];
+
+    DPRINTF(ControlPlane, "trigger #%d fired: DSid=%d, stat 0x%x = %d\n",
+            idx, trigger.DSid, trigger.stat_offset, trigger.last_value);
+
+    if (trigger.action & TRIGGER_ACTION_LOG) {
+        inform("%s: trigger #%d of DSid#%d fired, stat 0x%x = %d\n",
+               name(), idx, trigger.DSid, trigger.stat_offset,
+               trigger.last_value);
+    }
+
+    if (trigger.action & TRIGGER_ACTION_PARAM) {
+        uint32_t param_addr = ADDRTYPE_CFGTBL |
+                              (CFGTBL_TYPE_PARAM << 28) |
+                              (row << 10) | trigger.param_offset;
+        updateTable(trigger.DSid, param_addr, trigger.param_value);
+    }
+
+    if (trigger.action & TRIGGER_ACTION_INTR)
+        connector->raiseInterrupt();
+}
+
+void
+ControlPlane::processTriggerEvent()
+{
+    for (int i = 0; i < trigger_table_entries; i++) {
+        TriggerEntry &trigger = triggerTable[i];
+        if (!(trigger.flags & TRIGGER_FLAG_VALID))
+            continue;
+
+        // stat/param offsets must address a 64-bit field of a row, a
+        // param write must leave the DSid/flags word of the row alone
+        bool writes_param = trigger.action & TRIGGER_ACTION_PARAM;
+        if (trigger.stat_offset > 0x3F8 || trigger.param_offset > 0x3F8 ||
+            trigger.stat_offset % sizeof(uint64_t) ||
+            trigger.param_offset % sizeof(uint64_t) ||
+            (writes_param && trigger.param_offset < sizeof(uint64_t))) {
+            warn("%s: trigger #%d has bad offset, disabled\n", name(), i);
+            trigger.flags &= ~TRIGGER_FLAG_VALID;
+            continue;
+        }
+
+        int row = findTableRow(trigger.DSid);
+        if (row < 0)
+            continue;
+
+        uint32_t stat_addr = ADDRTYPE_CFGTBL |
+                             (CFGTBL_TYPE_STAT << 28) |
+                             (row << 10) | trigger.stat_offset;
+        trigger.last_value = queryTable(trigger.DSid, stat_addr);
+
+        if (evalTrigger(trigger, trigger.last_value)) {
+            if (!(trigger.flags & TRIGGER_FLAG_FIRED)) {
+                trigger.flags |= TRIGGER_FLAG_FIRED;
+                trigger.fire_count++;
+                fireTrigger(i, row);
+            }
+        } else {
+            trigger.flags &= ~TRIGGER_FLAG_FIRED;
+        }
+    }
+
+    // updateTrigger() starts the epochs again
+    if (anyValidTrigger())
+        schedule(triggerEvent, curTick() + triggerEpoch);
+}
@@ -4,15 +4,64 @@
 #include "params/ControlPlane.hh"
 #include "prm/AbstractControlPlane.hh"
 #include "prm/interfaces.hh"
+#include "sim/eventq.hh"
 
 /**
  * Forward declare of CPConnector class.
  */
 class CPConnector;
 
+/**
+ * Trigger table entry, the trigger table is CFGTBL_TYPE_TRIGGER.
+ *
+ * Every trigger_epoch, each valid trigger reads the stat at stat_offset
+ * of its DSid and compares it against threshold. A trigger fires once
+ * when its condition becomes true and re-arms when it becomes false.
+ * param_offset must not address the DSid/flags word at the start of
+ * the param row. Epochs only run while a trigger is valid.
+ */
+struct TriggerEntry {
+    uint16_t DSid;
+    uint16_t flags;
+    uint8_t  op;            // TRIGGER_OP_*
+    uint8_t  action;        // TRIGGER_ACTION_* bitmap
+    uint16_t __padding;
+    uint64_t stat_offset;   // byte offset in stat row of DSid
+    uint64_t threshold;
+    uint64_t param_offset;  // byte offset in param row of DSid
+    uint64_t param_value;   // written by TRIGGER_ACTION_PARAM
+    uint64_t fire_count;
+    uint64_t last_value;    // stat value of the last evaluation
+};
+
+#define TRIGGER_FLAG_VALID	0x8000
+#define TRIGGER_FLAG_FIRED	0x0001
+
+#define TRIGGER_OP_GT		0
+#define TRIGGER_OP_GE		1
+#define TRIGGER_OP_LT		2
+#define TRIGGER_OP_LE		3
+#define TRIGGER_OP_EQ		4
+#define TRIGGER_OP_NE		5
+
+#define TRIGGER_ACTION_LOG	0x01
+#define TRIGGER_ACTION_PARAM	0x02
+#define TRIGGER_ACTION_INTR	0x04
+
 /**
  * ControlPlane connect to CPN use CPConnector, and define
  * interfaces used by CPConnector.
+ *
+ * ControlPlane also owns the trigger table. A subclass supports
+ * triggers by overriding findTableRow() and passing trigger table
+ * addresses to queryTrigger()/updateTrigger(), stats are read and
+ * params are written through its own queryTable()/updateTable().
+ *
+ * A subclass with a DSid-indexed statistics table publishes it as a
+ * read-only window in BAR2 of the CPAdaptor by overriding
+ * statEntrySize()/statTableEntries(), unless stat_window is off.
+ * Window reads go through queryTable(), so fields computed on query
+ * are up to date.
  */
 class ControlPlane : public AbstractControlPlane
 {
@@ -30,6 +79,43 @@ class ControlPlane : public AbstractControlPlane
     virtual uint64_t queryTable(uint16_t DSid, uint32_t addr) { return 0; }
     virtual void updateTable(uint16_t DSid, uint32_t addr, uint64_t data) {}
 
+    /**
+     * Read from the statistics window, an access must not cross a
+     * 64-bit field.
+     *
+     * @return false if nothing is published at offset
+     */
+    bool readStatWindow(Addr offset, int size, uint8_t *data);
+
+  protected:
+    int trigger_table_entries;
+    struct TriggerEntry *triggerTable;
+    const Tick triggerEpoch;
+
+    /**
+     * Row of DSid in param/stat table, -1 if DSid has no valid row.
+     * The default disables triggers of this control plane.
+     */
+    virtual int findTableRow(uint16_t DSid) const { return -1; }
+
+    /** Layout of the statistics table, 0 means it is not published */
+    virtual size_t statEntrySize() const { return 0; }
+    virtual int statTableEntries() const { return 0; }
+    const bool statWindow;
+
+    bool isTriggerAddr(uint32_t addr) const;
+    uint64_t queryTrigger(uint32_t addr);
+    void updateTrigger(uint32_t addr, uint64_t data);
+
+  private:
+    uint64_t *parseTriggerAddr(uint32_t addr);
+    bool evalTrigger(const TriggerEntry &trigger, uint64_t value) const;
+    bool anyValidTrigger() const;
+    void fireTrigger(int idx, int row);
+
+    void processTriggerEvent();
+    EventWrapper<ControlPlane, &ControlPlane::processTriggerEvent> triggerEvent;
+
   protected:
     const Params * params() const
     { return dynamic_cast<const Params *>(_params); }
@@ -30,7 +30,14 @@ class ControlPlane(AbstractControlPlane):
     BAR1 = Param.UInt32(0x00, "Base Address Register 0")
     BAR1Size = Param.MemorySize32('0B', "Base Address Register 0 Size")
 
-    def connectToNetwork(self, cpn):
+    # Trigger table, evaluated every trigger_epoch
+    trigger_table_entries = Param.Int(0, "Trigger table size")
+    trigger_epoch = Param.Latency('1ms', "Trigger evaluation interval")
+
+    # Statistics table window in BAR2 of the CPAdaptor, if supported
+    stat_window = Param.Bool(True, "Publish statistics table to CPAdaptor")
+
+    def connectToNetwork(self, cpn, cpa = None):
         self.connector = CPConnector(cp_dev = self.cp_dev,
                                      cp_fun = self.cp_fun,
                                      Type   = self.Type,
@@ -38,6 +45,8 @@ class ControlPlane(AbstractControlPlane):
                                      BAR0   = self.BAR0,
                                      BAR0Size = self.BAR0Size)
         self.connector.slave = cpn.master
+        if cpa is not None:
+            self.connector.adaptor = cpa
 
     
 class GeneralControlPlane(ControlPlane):
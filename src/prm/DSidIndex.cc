@@ -0,0 +1,39 @@
+#include <cassert>
+
+#include "prm/DSidIndex.hh"
+
+DSidIndex::DSidIndex(int entries)
+    : owner(entries, -1)
+{
+}
+
+void
+DSidIndex::set(int row, int DSid)
+{
+    assert(row >= 0 && row < (int)owner.size());
+
+    int old = owner[row];
+    if (old == DSid)
+        return;
+    owner[row] = DSid;
+
+    // old DSid falls back to its next valid row, if any
+    if (old >= 0) {
+        auto it = rows.find(old);
+        if (it != rows.end() && it->second == row) {
+            rows.erase(it);
+            for (int i=0; i<(int)owner.size(); i++) {
+                if (owner[i] == old) {
+                    rows[old] = i;
+                    break;
+                }
+            }
+        }
+    }
+
+    if (DSid >= 0) {
+        auto it = rows.find(DSid);
+        if (it == rows.end() || it->second > row)
+            rows[DSid] = row;
+    }
+}
@@ -0,0 +1,39 @@
+#ifndef __PRM_DSID_INDEX_HH__
+#define __PRM_DSID_INDEX_HH__
+
+#include <unordered_map>
+#include <vector>
+
+#include "base/types.hh"
+
+/**
+ * DSid to row index of a control plane parameter table.
+ *
+ * The owning control plane calls set() whenever DSid or the valid
+ * flag of a row may have changed, lookups are then a hash probe
+ * instead of a table scan. Like the scans it replaces, a DSid found
+ * in several valid rows maps to the lowest one.
+ */
+class DSidIndex
+{
+  public:
+    DSidIndex(int entries);
+
+    /** Row of DSid, -1 if DSid has no valid row */
+    int find(uint16_t DSid) const
+    {
+        auto it = rows.find(DSid);
+        return (it == rows.end()) ? -1 : it->second;
+    }
+
+    /** Bind row to DSid, -1 if row is not valid */
+    void set(int row, int DSid);
+
+  private:
+    // DSid of each row, -1 if the row is not valid
+    std::vector<int> owner;
+    // lowest valid row of each DSid
+    std::unordered_map<uint16_t, int> rows;
+};
+
+#endif	// __PRM_DSID_INDEX_HH__
@@ -8,4 +8,12 @@ class ICommandHandler
         uint64_t arg1, uint64_t arg2, uint64_t arg3) = 0;
 };
 
+class ICommandListener
+{
+  public:
+    /** Command issued with cookie completed, data is its result */
+    virtual void commandDone(uint64_t cookie, bool known,
+        uint64_t data) = 0;
+};
+
 #endif	// __PRM_INTERFACES_HH__